@@ -0,0 +1,157 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Really tiny library to basic RTC functionality on Arduino.
+ *
+ * DateTime, TimeSpan and formatting micro-benchmark. No RTC is needed.
+ *
+ * Results are printed as CSV, one line per benchmark, so they can be captured from the serial
+ * port and compared across library versions:
+ *
+ *     benchmark,iterations,runs,median_ns_per_op,min_ns_per_op
+ *
+ * Each benchmark runs once to warm up (caches, branch predictors, flash wait states), then BENCH_RUNS
+ * times; iterations is per run. Rounds are scaled per platform so every run is long compared to the
+ * micros() resolution, from 4us on AVR to 1us on hosts.
+ *
+ * Inputs are random timestamps between 2000 and 2099 with a fixed seed, so every run
+ * (and every board) uses the same distribution.
+ *
+ * @copyright Naguissa
+ * @author Naguissa
+ * @url https://github.com/Naguissa/uRTCLib
+ * @url https://www.foroelectro.net/librerias-arduino-ide-f29/rtclib-arduino-libreria-simple-y-eficaz-para-rtc-y-t95.html
+ * @email naguissa@foroelectro.net
+ */
+#include "Arduino.h"
+#include "uRTCLib.h"
+
+// Keep it small enough for 2KB RAM boards: 32 * (4 + 7 + 4 + 7) bytes
+#define BENCH_SAMPLES 32
+#define BENCH_RUNS 5
+#if defined(__AVR__)
+#define BENCH_ROUNDS 16
+#elif defined(URTCLIB_LINUX)
+#define BENCH_ROUNDS 4096
+#else
+#define BENCH_ROUNDS 256
+#endif
+
+uint32_t unixtimes[BENCH_SAMPLES];
+DateTime datetimes[BENCH_SAMPLES];
+TimeSpan timespans[BENCH_SAMPLES];
+uint8_t registers[BENCH_SAMPLES][7]; // Time blocks as read from RTC, BCD
+
+// Byte at a time BCD decoding of a time block, as uRTCLib did before uRTCLibBcd::decodeTimeBlock()
+const uint8_t registerMasks[7] = {0b01111111, 0b01111111, 0b00111111, 0b00000111, 0b00111111, 0b00011111, 0b11111111};
+void decodeBytes(uint8_t *block) {
+	for (uint8_t field = 0; field < 7; field++) {
+		uint8_t value = block[field] & registerMasks[field];
+		block[field] = value - 6 * (value >> 4);
+	}
+}
+
+// Results are accumulated here so the compiler cannot drop the benchmarked code
+volatile uint32_t sink;
+
+// Prints ns per operation with one decimal, from a run time in microseconds
+void printNs(uint32_t us) {
+	uint32_t tenths = (uint64_t) us * 10000 / ((uint32_t) BENCH_SAMPLES * BENCH_ROUNDS);
+	Serial.print(tenths / 10);
+	Serial.print('.');
+	Serial.print(tenths % 10);
+}
+
+void report(const char *name, uint32_t *runs) {
+	// Insertion sort, BENCH_RUNS is small
+	for (uint8_t i = 1; i < BENCH_RUNS; i++) {
+		for (uint8_t j = i; j > 0 && runs[j] < runs[j - 1]; j--) {
+			uint32_t swap = runs[j];
+			runs[j] = runs[j - 1];
+			runs[j - 1] = swap;
+		}
+	}
+	Serial.print(name);
+	Serial.print(',');
+	Serial.print((uint32_t) BENCH_SAMPLES * BENCH_ROUNDS);
+	Serial.print(',');
+	Serial.print(BENCH_RUNS);
+	Serial.print(',');
+	printNs(runs[BENCH_RUNS / 2]);
+	Serial.print(',');
+	printNs(runs[0]);
+	Serial.println();
+}
+
+// Runs EXPR for every sample BENCH_ROUNDS times, once to warm up and then BENCH_RUNS timed times; i is the sample index
+#define BENCH(NAME, EXPR) \
+	{ \
+		uint32_t runs[BENCH_RUNS]; \
+		for (uint8_t run = 0; run <= BENCH_RUNS; run++) { \
+			uint32_t start = micros(); \
+			for (uint16_t round = 0; round < BENCH_ROUNDS; round++) { \
+				for (uint8_t i = 0; i < BENCH_SAMPLES; i++) { \
+					EXPR; \
+				} \
+			} \
+			if (run) { \
+				runs[run - 1] = micros() - start; \
+			} \
+		} \
+		report(NAME, runs); \
+	}
+
+void setup() {
+	Serial.begin(115200);
+	while (!Serial)
+		; //delay for Leonardo
+
+	randomSeed(42);
+	for (uint8_t i = 0; i < BENCH_SAMPLES; i++) {
+		// random() returns up to 2^31 - 1, two calls are needed to cover a whole century
+		unixtimes[i] = SECONDS_FROM_1970_TO_2000 + (((uint32_t) random(0x10000) << 16) | random(0x10000)) % 3155760000UL;
+		datetimes[i] = DateTime(unixtimes[i]);
+		// Mostly short spans, as in sampling loops, with some of up to a year
+		timespans[i] = TimeSpan(i % 4 ? random(3600) : random(31536000L));
+		registers[i][0] = uRTCLibBcd::bin2bcd(datetimes[i].second());
+		registers[i][1] = uRTCLibBcd::bin2bcd(datetimes[i].minute());
+		registers[i][2] = uRTCLibBcd::bin2bcd(datetimes[i].hour());
+		registers[i][3] = datetimes[i].dayOfTheWeek() + 1;
+		registers[i][4] = uRTCLibBcd::bin2bcd(datetimes[i].day());
+		registers[i][5] = uRTCLibBcd::bin2bcd(datetimes[i].month());
+		registers[i][6] = uRTCLibBcd::bin2bcd(datetimes[i].year() - 2000);
+	}
+
+	char buffer[32];
+	uint8_t block[7];
+	DateTime step;
+
+	Serial.println("benchmark,iterations,runs,median_ns_per_op,min_ns_per_op");
+	BENCH("DateTime(uint32_t)", sink += DateTime(unixtimes[i]).second());
+	BENCH("unixtime", sink += datetimes[i].unixtime());
+	BENCH("dayOfTheWeek", sink += datetimes[i].dayOfTheWeek());
+	BENCH("operator<", sink += datetimes[i] < datetimes[(i + 1) % BENCH_SAMPLES]);
+	BENCH("operator+(TimeSpan)", sink += (datetimes[i] + timespans[i]).second());
+	// Small fixed steps, as in sampling loops: full conversion against in-place field carry. Steps are taken on a
+	// copy, so samples stay the same for every row whatever the number of rounds
+	BENCH("DateTime(unixtime()+1)", step = datetimes[i]; step = DateTime(step.unixtime() + 1); sink += step.second());
+	BENCH("operator+=(TimeSpan(1))", step = datetimes[i]; step += TimeSpan(1); sink += step.second());
+	BENCH("addSeconds(300)", step = datetimes[i]; sink += step.addSeconds(300).second());
+	BENCH("addDays(1)", step = datetimes[i]; sink += step.addDays(1).day());
+	// Register block decoding, as in now(): one bcd2bin per byte against two SWAR words
+	BENCH("BCD block per byte", memcpy(block, registers[i], 7); decodeBytes(block); sink += block[0] + block[6]);
+	BENCH("uRTCLibBcd::decodeTimeBlock", memcpy(block, registers[i], 7); uRTCLibBcd::decodeTimeBlock(block); sink += block[0] + block[6]);
+	BENCH("toString", strcpy(buffer, "DDD, DD MMM YYYY hh:mm:ss"); sink += datetimes[i].toString(buffer)[0]);
+	BENCH("timestamp", sink += datetimes[i].timestamp().length());
+	BENCH("TimeSpan::days", sink += timespans[i].days());
+	BENCH("TimeSpan::hours", sink += timespans[i].hours());
+	BENCH("TimeSpan::minutes", sink += timespans[i].minutes());
+	BENCH("TimeSpan::seconds", sink += timespans[i].seconds());
+	// All fields at once: four TimeSpan accessors against one Duration::split()
+	BENCH("TimeSpan d+h+m+s", sink += timespans[i].days() + timespans[i].hours() + timespans[i].minutes() + timespans[i].seconds());
+	BENCH("Duration::split", Duration::Parts p = Duration(timespans[i]).split(); sink += p.days + p.hours + p.minutes + p.seconds);
+	Serial.println("done");
+}
+
+void loop() {
+}
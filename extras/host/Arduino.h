@@ -0,0 +1,42 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host shim: the Arduino API used by example sketches that need no RTC, on top of uRTCLibLinux.h, so they run
+ * on Linux. Only for CMake host targets, Arduino builds never see it.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#ifndef URTCLIB_HOST_ARDUINO_H
+#define URTCLIB_HOST_ARDUINO_H
+#include <stdlib.h>
+#include "uRTCLibLinux.h"
+
+/**
+ * \brief Serial on stdout
+ */
+class HostSerial : public Print
+{
+public:
+	void begin(const unsigned long) {}
+	operator bool() const { return true; }
+	using Print::println;
+	template <class T>
+	void println(const T value)
+	{
+		print(value);
+		print('\n');
+	}
+};
+
+extern HostSerial Serial;
+
+/**
+ * \brief Random number from 0 to max - 1, as Arduino random()
+ */
+static inline long random(const long max) { return max ? ::random() % max : 0; }
+
+static inline void randomSeed(const unsigned long seed) { srandom(seed); }
+
+#endif
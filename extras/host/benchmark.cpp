@@ -0,0 +1,20 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host runner for examples/uRTCLib_benchmark: same sketch, same CSV output, on stdout.
+ *
+ *     cmake -S . -B build && cmake --build build --target benchmark
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib_benchmark.ino"
+
+HostSerial Serial;
+
+int main()
+{
+	setup();
+	return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * DateTime::toCivil() / DateTime::toUnix() throughput on host, against converting one element at a time.
+ *
+ * Results are printed as CSV, one line per conversion:
+ *
+ *     kernel,conversion,elements,ns_per_conversion,mconversions_per_s
+ *
+ * kernel is "sse4.1" when built with -msse4.1 (uRTCLib_convert_benchmark_sse41), "scalar" otherwise. Each
+ * conversion runs once to warm up, then RUNS times; the median run is reported.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "uRTCLib.h"
+
+#define ELEMENTS (1 << 20)
+#define RUNS 9
+
+#if defined(__SSE4_1__)
+#define KERNEL "sse4.1"
+#else
+#define KERNEL "scalar"
+#endif
+
+static std::vector<uint32_t> unixtimes(ELEMENTS), unixtimesOut(ELEMENTS);
+static std::vector<DateTime> datetimes(ELEMENTS), datetimesOut(ELEMENTS);
+
+static void perElementCivil()
+{
+	for (size_t i = 0; i < ELEMENTS; i++)
+		datetimesOut[i] = DateTime(unixtimes[i]);
+}
+
+static void bulkCivil() { DateTime::toCivil(unixtimes.data(), datetimesOut.data(), ELEMENTS); }
+
+static void perElementUnix()
+{
+	for (size_t i = 0; i < ELEMENTS; i++)
+		unixtimesOut[i] = datetimes[i].unixtime();
+}
+
+static void bulkUnix() { DateTime::toUnix(datetimes.data(), unixtimesOut.data(), ELEMENTS); }
+
+static void run(const char *name, void (*conversion)())
+{
+	double ns[RUNS];
+
+	conversion();
+	for (int r = 0; r < RUNS; r++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		conversion();
+		ns[r] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ELEMENTS;
+	}
+	std::sort(ns, ns + RUNS);
+	printf("%s,%s,%d,%.2f,%.1f\n", KERNEL, name, ELEMENTS, ns[RUNS / 2], 1000 / ns[RUNS / 2]);
+}
+
+int main()
+{
+	std::mt19937 random(42);
+	for (size_t i = 0; i < ELEMENTS; i++)
+	{
+		unixtimes[i] = SECONDS_FROM_1970_TO_2000 + random() % 3155760000UL; // 2000 to 2099
+		datetimes[i] = DateTime(unixtimes[i]);
+	}
+
+	printf("kernel,conversion,elements,ns_per_conversion,mconversions_per_s\n");
+	run("DateTime(uint32_t)", perElementCivil);
+	run("toCivil", bulkCivil);
+	run("unixtime()", perElementUnix);
+	run("toUnix", bulkUnix);
+	return 0;
+}
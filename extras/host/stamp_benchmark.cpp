@@ -0,0 +1,101 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibStampEncoder / uRTCLibStampDecoder benchmark on host: size and speed over synthetic event logs.
+ *
+ * Results are printed as CSV, one line per dataset:
+ *
+ *     dataset,stamps,bytes,bytes_per_stamp,encode_ns,next_ns,decode_ns
+ *
+ * encode_ns, next_ns and decode_ns are per stamp; decode is the bulk decoder. Datasets use a fixed seed.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <chrono>
+#include <random>
+#include <vector>
+#include "uRTCLib.h"
+
+#define STAMPS 1000000
+
+static double nsPerStamp(const std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / STAMPS;
+}
+
+static void run(const char *name, const std::vector<uint32_t> &stamps)
+{
+	std::vector<uint8_t> buffer(stamps.size() * URTCLIB_STAMP_MAX_BYTES);
+	std::vector<uint32_t> decoded(stamps.size());
+	uRTCLibStampEncoder encoder;
+	size_t length = 0;
+	uint32_t sink = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < stamps.size(); i++)
+	{
+		length += encoder.encode(stamps[i], &buffer[length]);
+	}
+	length += encoder.flush(&buffer[length]);
+	double encodeNs = nsPerStamp(start);
+
+	start = std::chrono::steady_clock::now();
+	uRTCLibStampDecoder decoder(buffer.data(), length);
+	for (uint32_t stamp; decoder.next(stamp);)
+	{
+		sink += stamp;
+	}
+	double nextNs = nsPerStamp(start);
+
+	start = std::chrono::steady_clock::now();
+	size_t count = uRTCLibStampDecoder::decode(buffer.data(), length, decoded.data(), decoded.size());
+	double decodeNs = nsPerStamp(start);
+
+	if (count != stamps.size() || decoded != stamps || sink == 1)
+	{
+		printf("%s,decode mismatch\n", name);
+		return;
+	}
+	printf("%s,%zu,%zu,%.3g,%.2f,%.2f,%.2f\n", name, stamps.size(), length, (double)length / stamps.size(), encodeNs, nextNs, decodeNs);
+}
+
+int main()
+{
+	std::mt19937 random(42);
+	std::vector<uint32_t> stamps(STAMPS);
+	uint32_t t;
+
+	printf("dataset,stamps,bytes,bytes_per_stamp,encode_ns,next_ns,decode_ns\n");
+
+	t = 1700000000;
+	for (size_t i = 0; i < STAMPS; i++)
+		stamps[i] = t += 60;
+	run("periodic 60s", stamps);
+
+	// 1 in 100 samples is taken 1 second late or early, as a polling loop would
+	t = 1700000000;
+	for (size_t i = 0; i < STAMPS; i++)
+		stamps[i] = (t += 60) + (random() % 100 ? 0 : (random() & 2) - 1);
+	run("periodic 60s, 1% jitter", stamps);
+
+	// Events: exponential intervals, mean 5 minutes
+	std::exponential_distribution<double> interval(1 / 300.0);
+	t = 1700000000;
+	for (size_t i = 0; i < STAMPS; i++)
+		stamps[i] = t += (uint32_t)interval(random);
+	run("events, mean 300s", stamps);
+
+	// Bursts of 1-20 stamps 1 second apart, every ~hour
+	t = 1700000000;
+	for (size_t i = 0; i < STAMPS;)
+	{
+		t += 3000 + random() % 1200;
+		for (uint32_t burst = 1 + random() % 20; burst && i < STAMPS; burst--)
+			stamps[i++] = t++;
+	}
+	run("bursts", stamps);
+
+	return 0;
+}
@@ -0,0 +1,35 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Replays uRTCLibWakeProbe samples captured from Serial (see uRTCLibWakeProbe::setLog()) and prints their
+ * histograms, as the board would with uRTCLibWakeProbe::dump(). Other lines in the capture are skipped.
+ *
+ *     uRTCLib_wake_replay < serial_capture.txt
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+
+int main()
+{
+	uRTCLib rtc; // not opened, samples only
+	uRTCLibWakeProbe probe(rtc);
+	uRTCLibWakeSample sample;
+	Print out;
+	char line[128];
+	unsigned long count = 0;
+
+	while (fgets(line, sizeof(line), stdin))
+	{
+		if (uRTCLibWakeProbe::parse(line, sample))
+		{
+			probe.add(sample);
+			count++;
+		}
+	}
+	fprintf(stderr, "%lu samples\n", count);
+	probe.dump(out);
+	return 0;
+}
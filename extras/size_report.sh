@@ -0,0 +1,59 @@
+#!/bin/sh
+#
+# uRTCLib feature size report
+#
+# Compiles src/uRTCLib.cpp once with default features and once per URTCLIB_NO_XXX flag,
+# and prints how many .text, .data and .bss bytes each feature costs. Opt-in features
+# (URTCLIB_XXX flags) are measured the same way, by adding them.
+#
+# Usage, from repository root or any other place:
+#
+#     CXX=avr-g++ SIZE=avr-size CXXFLAGS="-mmcu=attiny85 -I/path/to/core -I/path/to/Wire/src" extras/size_report.sh
+#
+# Defaults to host g++ and size; Arduino core and Wire include paths must be supplied in CXXFLAGS.
+#
+# @copyright Naguissa
+# @author Naguissa
+# @url https://github.com/Naguissa/uRTCLib
+# @email naguissa@foroelectro.net
+
+CXX=${CXX:-g++}
+SIZE=${SIZE:-size}
+CXXFLAGS=${CXXFLAGS:-}
+FEATURES="ALARMS SQWG 32KHZ RAM TEMP CACHE RECOVERY"
+OPT_IN="SNAPSHOT STALENESS"
+
+SRC="$(cd "$(dirname "$0")/.." && pwd)/src"
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+# Prints "text data bss" for given extra flags
+measure() {
+	# shellcheck disable=SC2086
+	$CXX -Os -std=gnu++11 -c $CXXFLAGS -I"$SRC" "$@" "$SRC/uRTCLib.cpp" -o "$TMP/uRTCLib.o" || exit 1
+	$SIZE "$TMP/uRTCLib.o" | awk 'NR == 2 { print $1, $2, $3 }'
+}
+
+set -- $(measure)
+FULL_TEXT=$1
+FULL_DATA=$2
+FULL_BSS=$3
+
+printf '%-10s %8s %8s %8s\n' feature .text .data .bss
+printf '%-10s %8s %8s %8s\n' default "$FULL_TEXT" "$FULL_DATA" "$FULL_BSS"
+for FEATURE in $FEATURES; do
+	set -- $(measure -DURTCLIB_NO_$FEATURE)
+	printf '%-10s %8s %8s %8s\n' "$FEATURE" $((FULL_TEXT - $1)) $((FULL_DATA - $2)) $((FULL_BSS - $3))
+done
+
+for FEATURE in $OPT_IN; do
+	set -- $(measure -DURTCLIB_$FEATURE)
+	printf '%-10s %8s %8s %8s\n' "+$FEATURE" $(($1 - FULL_TEXT)) $(($2 - FULL_DATA)) $(($3 - FULL_BSS))
+done
+
+FLAGS=""
+for FEATURE in $FEATURES; do
+	FLAGS="$FLAGS -DURTCLIB_NO_$FEATURE"
+done
+set -- $(measure $FLAGS)
+printf '%-10s %8s %8s %8s\n' minimal "$1" "$2" "$3"
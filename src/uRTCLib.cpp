@@ -24,551 +24,451 @@
  * @version 6.2.4
  */
 
-#include <Arduino.h>
-#include <Wire.h>
 #include "uRTCLib.h"
+#if defined(URTCLIB_LINUX)
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#endif
+/**
+ * \brief Constructor
+ */
+uRTCLib::uRTCLib() {}
 
-/**************************************************************************/
-// utility code, some of this could be exposed in the DateTime API if needed
-/**************************************************************************/
-
-/**
-  Number of days in each month, from January to November. December is not
-  needed. Omitting it avoids an incompatibility with Paul Stoffregen's Time
-  library. C.f. https://github.com/adafruit/RTClib/issues/114
-*/
-const uint8_t daysInMonth[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
-
-/**************************************************************************/
-/*!
-    @brief  Given a date, return number of days since 2000/01/01, valid for 2001..2099
-    @param y Year
-    @param m Month
-    @param d Day
-    @return Number of days
-*/
-/**************************************************************************/
-static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d)
-{
-	if (y >= 2000)
-		y -= 2000;
-	uint16_t days = d;
-	for (uint8_t i = 1; i < m; ++i)
-		days += pgm_read_byte(daysInMonth + i - 1);
-	if (m > 2 && y % 4 == 0)
-		++days;
-	return days + 365 * y + (y + 3) / 4 - 1;
-}
-
-/**************************************************************************/
-/*!
-    @brief  Given a number of days, hours, minutes, and seconds, return the total seconds
-    @param days Days
-    @param h Hours
-    @param m Minutes
-    @param s Seconds
-    @return Number of seconds total
-*/
-/**************************************************************************/
-static long time2long(uint16_t days, uint8_t h, uint8_t m, uint8_t s)
-{
-	return ((days * 24L + h) * 60 + m) * 60 + s;
-}
-
-/**************************************************************************/
-/*!
-    @brief  DateTime constructor from unixtime
-    @param t Initial time in seconds since Jan 1, 1970 (Unix time)
-*/
-/**************************************************************************/
-DateTime::DateTime(uint32_t t)
-{
-	t -= SECONDS_FROM_1970_TO_2000; // bring to 2000 timestamp from 1970
-
-	ss = t % 60;
-	t /= 60;
-	mm = t % 60;
-	t /= 60;
-	hh = t % 24;
-	uint16_t days = t / 24;
-	uint8_t leap;
-	for (yOff = 0;; ++yOff)
-	{
-		leap = yOff % 4 == 0;
-		if (days < 365 + leap)
-			break;
-		days -= 365 + leap;
-	}
-	for (m = 1; m < 12; ++m)
-	{
-		uint8_t daysPerMonth = pgm_read_byte(daysInMonth + m - 1);
-		if (leap && m == 2)
-			++daysPerMonth;
-		if (days < daysPerMonth)
-			break;
-		days -= daysPerMonth;
-	}
-	d = days + 1;
-}
-
-/**************************************************************************/
-/*!
-    @brief  DateTime constructor from Y-M-D H:M:S
-    @param year Year, 2 or 4 digits (year 2000 or higher)
-    @param month Month 1-12
-    @param day Day 1-31
-    @param hour 0-23
-    @param min 0-59
-    @param sec 0-59
-*/
-/**************************************************************************/
-DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
-{
-	if (year >= 2000)
-		year -= 2000;
-	yOff = year;
-	m = month;
-	d = day;
-	hh = hour;
-	mm = min;
-	ss = sec;
-}
-
-/**************************************************************************/
-/*!
-    @brief  DateTime copy constructor using a member initializer list
-    @param copy DateTime object to copy
-*/
-/**************************************************************************/
-DateTime::DateTime(const DateTime &copy) : yOff(copy.yOff),
-																					 m(copy.m),
-																					 d(copy.d),
-																					 hh(copy.hh),
-																					 mm(copy.mm),
-																					 ss(copy.ss)
-{
-}
-
-/**************************************************************************/
-/*!
-    @brief  Convert a string containing two digits to uint8_t, e.g. "09" returns 9
-    @param p Pointer to a string containing two digits
-*/
-/**************************************************************************/
-static uint8_t conv2d(const char *p)
-{
-	uint8_t v = 0;
-	if ('0' <= *p && *p <= '9')
-		v = *p - '0';
-	return 10 * v + *++p - '0';
-}
-
-/**************************************************************************/
-/*!
-    @brief  A convenient constructor for using "the compiler's time":
-            DateTime now (__DATE__, __TIME__);
-            NOTE: using F() would further reduce the RAM footprint, see below.
-    @param date Date string, e.g. "Dec 26 2009"
-    @param time Time string, e.g. "12:34:56"
-*/
-/**************************************************************************/
-DateTime::DateTime(const char *date, const char *time)
-{
-	// sample input: date = "Dec 26 2009", time = "12:34:56"
-	yOff = conv2d(date + 9);
-	// Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
-	switch (date[0])
-	{
-	case 'J':
-		m = (date[1] == 'a') ? 1 : ((date[2] == 'n') ? 6 : 7);
-		break;
-	case 'F':
-		m = 2;
-		break;
-	case 'A':
-		m = date[2] == 'r' ? 4 : 8;
-		break;
-	case 'M':
-		m = date[2] == 'r' ? 3 : 5;
-		break;
-	case 'S':
-		m = 9;
-		break;
-	case 'O':
-		m = 10;
-		break;
-	case 'N':
-		m = 11;
-		break;
-	case 'D':
-		m = 12;
-		break;
-	}
-	d = conv2d(date + 4);
-	hh = conv2d(time);
-	mm = conv2d(time + 3);
-	ss = conv2d(time + 6);
-}
-
-/**************************************************************************/
-/*!
-    @brief  A convenient constructor for using "the compiler's time":
-            This version will save RAM by using PROGMEM to store it by using the F macro.
-            DateTime now (F(__DATE__), F(__TIME__));
-    @param date Date string, e.g. "Dec 26 2009"
-    @param time Time string, e.g. "12:34:56"
-*/
-/**************************************************************************/
-DateTime::DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time)
-{
-	// sample input: date = "Dec 26 2009", time = "12:34:56"
-	char buff[11];
-	memcpy_P(buff, date, 11);
-	yOff = conv2d(buff + 9);
-	// Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
-	switch (buff[0])
-	{
-	case 'J':
-		m = (buff[1] == 'a') ? 1 : ((buff[2] == 'n') ? 6 : 7);
-		break;
-	case 'F':
-		m = 2;
-		break;
-	case 'A':
-		m = buff[2] == 'r' ? 4 : 8;
-		break;
-	case 'M':
-		m = buff[2] == 'r' ? 3 : 5;
-		break;
-	case 'S':
-		m = 9;
-		break;
-	case 'O':
-		m = 10;
-		break;
-	case 'N':
-		m = 11;
-		break;
-	case 'D':
-		m = 12;
-		break;
-	}
-	d = conv2d(buff + 4);
-	memcpy_P(buff, time, 8);
-	hh = conv2d(buff);
-	mm = conv2d(buff + 3);
-	ss = conv2d(buff + 6);
-}
-
-/**************************************************************************/
-/*!
-    @brief  Return DateTime in based on user defined format.
-    @param buffer: array of char for holding the format description and the formatted DateTime. 
-                   Before calling this method, the buffer should be initialized by the user with 
-                   a format string, e.g. "YYYY-MM-DD hh:mm:ss". The method will overwrite 
-                   the buffer with the formatted date and/or time.
-    @return a pointer to the provided buffer. This is returned for convenience, 
-            in order to enable idioms such as Serial.println(now.toString(buffer));
-*/
-/**************************************************************************/
-
-char *DateTime::toString(char *buffer)
-{
-	for (int i = 0; i < strlen(buffer) - 1; i++)
-	{
-		if (buffer[i] == 'h' && buffer[i + 1] == 'h')
-		{
-			buffer[i] = '0' + hh / 10;
-			buffer[i + 1] = '0' + hh % 10;
-		}
-		if (buffer[i] == 'm' && buffer[i + 1] == 'm')
-		{
-			buffer[i] = '0' + mm / 10;
-			buffer[i + 1] = '0' + mm % 10;
-		}
-		if (buffer[i] == 's' && buffer[i + 1] == 's')
-		{
-			buffer[i] = '0' + ss / 10;
-			buffer[i + 1] = '0' + ss % 10;
-		}
-		if (buffer[i] == 'D' && buffer[i + 1] == 'D' && buffer[i + 2] == 'D')
-		{
-			static PROGMEM const char day_names[] = "SunMonTueWedThuFriSat";
-			const char *p = &day_names[3 * dayOfTheWeek()];
-			buffer[i] = pgm_read_byte(p);
-			buffer[i + 1] = pgm_read_byte(p + 1);
-			buffer[i + 2] = pgm_read_byte(p + 2);
-		}
-		else if (buffer[i] == 'D' && buffer[i + 1] == 'D')
-		{
-			buffer[i] = '0' + d / 10;
-			buffer[i + 1] = '0' + d % 10;
-		}
-		if (buffer[i] == 'M' && buffer[i + 1] == 'M' && buffer[i + 2] == 'M')
-		{
-			static PROGMEM const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
-			const char *p = &month_names[3 * (m - 1)];
-			buffer[i] = pgm_read_byte(p);
-			buffer[i + 1] = pgm_read_byte(p + 1);
-			buffer[i + 2] = pgm_read_byte(p + 2);
-		}
-		else if (buffer[i] == 'M' && buffer[i + 1] == 'M')
-		{
-			buffer[i] = '0' + m / 10;
-			buffer[i + 1] = '0' + m % 10;
-		}
-		if (buffer[i] == 'Y' && buffer[i + 1] == 'Y' && buffer[i + 2] == 'Y' && buffer[i + 3] == 'Y')
-		{
-			buffer[i] = '2';
-			buffer[i + 1] = '0';
-			buffer[i + 2] = '0' + (yOff / 10) % 10;
-			buffer[i + 3] = '0' + yOff % 10;
-		}
-		else if (buffer[i] == 'Y' && buffer[i + 1] == 'Y')
-		{
-			buffer[i] = '0' + (yOff / 10) % 10;
-			buffer[i + 1] = '0' + yOff % 10;
-		}
-	}
-	return buffer;
+/**
+ * \brief Constructor
+ *
+ * @param rtc_address I2C address of RTC
+ */
+uRTCLib::uRTCLib(const int rtc_address)
+{
+	_rtc_address = rtc_address;
 }
 
-/**************************************************************************/
-/*!
-    @brief  Return the day of the week for this object, from 0-6.
-    @return Day of week 0-6 starting with Sunday, e.g. Sunday = 0, Saturday = 6
-*/
-/**************************************************************************/
-uint8_t DateTime::dayOfTheWeek() const
+/**
+ * \brief Constructor
+ *
+ * @param rtc_address I2C address of RTC
+ * @param model RTC model:
+ *	 - #URTCLIB_MODEL_DS1307
+ *	 - #URTCLIB_MODEL_DS3231
+ *	 - #URTCLIB_MODEL_DS3232
+ */
+uRTCLib::uRTCLib(const int rtc_address, const uint8_t model)
 {
-	uint16_t day = date2days(yOff, m, d);
-	return (day + 6) % 7; // Jan 1, 2000 is a Saturday, i.e. returns 6
+	_rtc_address = rtc_address;
+	set_model(model);
 }
 
-/**************************************************************************/
-/*!
-    @brief  Return unix time, seconds since Jan 1, 1970.
-    @return Number of seconds since Jan 1, 1970
-*/
-/**************************************************************************/
-uint32_t DateTime::unixtime(void) const
+/************** Register descriptors ****************/
+
+#if !defined(URTCLIB_NO_SQWG)
+/**
+ * \brief SQWG mode to control register bits
+ */
+struct uRTCLibSqwgBits
 {
-	uint32_t t;
-	uint16_t days = date2days(yOff, m, d);
-	t = time2long(days, hh, mm, ss);
-	t += SECONDS_FROM_1970_TO_2000; // seconds from 1970 to 2000
-
-	return t;
-}
-
-/**************************************************************************/
-/*!
-    @brief  Convert the DateTime to seconds
-    @return The object as seconds since 2000-01-01
-*/
-/**************************************************************************/
-long DateTime::secondstime(void) const
-{
-	long t;
-	uint16_t days = date2days(yOff, m, d);
-	t = time2long(days, hh, mm, ss);
-	return t;
-}
+	uint8_t mode;		 ///< URTCLIB_SQWG_XXX mode
+	uint8_t andMask; ///< Control register bits to keep
+	uint8_t orMask;	///< Control register bits to set
+};
 
-/**************************************************************************/
-/*!
-    @brief  Add a TimeSpan to the DateTime object
-    @param span TimeSpan object
-    @return new DateTime object with span added to it
-*/
-/**************************************************************************/
-DateTime DateTime::operator+(const TimeSpan &span)
-{
-	return DateTime(unixtime() + span.totalseconds());
-}
+/**
+ * \brief DS1307 SQWG modes, control register OUT, SQWE, RS1 and RS0 bits; whole register is written
+ */
+const uRTCLibSqwgBits sqwgDS1307[] PROGMEM = {
+		{URTCLIB_SQWG_OFF_0, 0b00000000, 0b00000000},
+		{URTCLIB_SQWG_OFF_1, 0b00000000, 0b10000000},		// OUT
+		{URTCLIB_SQWG_1H, 0b00000000, 0b00010000},				// SQWE
+		{URTCLIB_SQWG_4096H, 0b00000000, 0b00010001},		// SQWE, RS0
+		{URTCLIB_SQWG_8192H, 0b00000000, 0b00010010},		// SQWE, RS1
+		{URTCLIB_SQWG_32768H, 0b00000000, 0b00010011}};	// SQWE, RS1, RS0
+
+/**
+ * \brief DS3231 and DS3232 SQWG modes, control register RS2, RS1 and INTCN bits
+ */
+const uRTCLibSqwgBits sqwgDS323x[] PROGMEM = {
+		{URTCLIB_SQWG_OFF_1, 0b11111111, 0b00000100},	 // INTCN
+		{URTCLIB_SQWG_1H, 0b11100011, 0b00000000},
+		{URTCLIB_SQWG_1024H, 0b11100011, 0b00001000}, // RS1
+		{URTCLIB_SQWG_4096H, 0b11100011, 0b00010000}, // RS2
+		{URTCLIB_SQWG_8192H, 0b11100011, 0b00011000}}; // RS2, RS1
 
-/**************************************************************************/
-/*!
-    @brief  Subtract a TimeSpan from the DateTime object
-    @param span TimeSpan object
-    @return new DateTime object with span subtracted from it
-*/
-/**************************************************************************/
-DateTime DateTime::operator-(const TimeSpan &span)
+/**
+ * \brief Per model SQWG layout
+ */
+struct uRTCLibSqwgRegs
 {
-	return DateTime(unixtime() - span.totalseconds());
-}
+	uint8_t reg;									 ///< SQWG control register
+	uint8_t count;								 ///< Entries in modes
+	const uRTCLibSqwgBits *modes; ///< SQWG modes, in PROGMEM
+};
+
+/**
+ * \brief SQWG layouts, indexed by URTCLIB_MODEL_XXX - 1
+ */
+const uRTCLibSqwgRegs sqwgRegs[] PROGMEM = {
+		{0x07, 6, sqwgDS1307},	// DS1307
+		{0x0E, 5, sqwgDS323x},	// DS3231
+		{0x0E, 5, sqwgDS323x}}; // DS3232
+#endif
+
+#if !defined(URTCLIB_NO_ALARMS)
+/**
+ * \brief Alarm support, indexed by URTCLIB_MODEL_XXX - 1
+ */
+const bool alarmModels[] PROGMEM = {false, true, true}; // DS1307, DS3231, DS3232
 
-/**************************************************************************/
-/*!
-    @brief  Subtract one DateTime from another
-    @param right The DateTime object to subtract from self (the left object)
-    @return TimeSpan of the difference between DateTimes
-*/
-/**************************************************************************/
-TimeSpan DateTime::operator-(const DateTime &right)
+/**
+ * \brief Alarm registers and bits
+ */
+struct uRTCLibAlarmRegs
 {
-	return TimeSpan(unixtime() - right.unixtime());
-}
+	uint8_t reg;				///< First alarm register
+	uint8_t firstField; ///< First field in register order: 0 second, 1 minute
+	uint8_t bit;				///< AxIE bit in control register, AxF bit in status register
+};
+
+/**
+ * \brief Alarm 1 and Alarm 2 layouts
+ *
+ * Registers are second (Alarm 1 only), minute, hour and day/dow; each one has its AxMy mode bit as bit 7,
+ * taken from bit y - 1 of alarm type, and day/dow has DY/DT as bit 6, taken from alarm type bit 4.
+ */
+const uRTCLibAlarmRegs alarmRegs[] PROGMEM = {
+		{0x07, 0, 0b00000001},	// Alarm 1: A1IE, A1F
+		{0x0B, 1, 0b00000010}}; // Alarm 2: A2IE, A2F
 
-/**************************************************************************/
-/*!
-    @brief  Is one DateTime object less than (older) than the other?
-    @param right Comparison DateTime object
-    @return True if the left object is older than the right object
-*/
-/**************************************************************************/
-bool DateTime::operator<(const DateTime &right) const
+/**
+ * \brief Returns alarm registers table index
+ *
+ * @param alarm #URTCLIB_ALARM_1 or #URTCLIB_ALARM_2
+ *
+ * @return 0 or 1, 2 if alarm is not valid
+ */
+static uint8_t alarmIndex(const uint8_t alarm)
 {
-	return unixtime() < right.unixtime();
+	return alarm == URTCLIB_ALARM_1 ? 0 : (alarm == URTCLIB_ALARM_2 ? 1 : 2);
 }
+#endif
 
-/**************************************************************************/
-/*!
-    @brief  Is one DateTime object equal to the other?
-    @param right Comparison DateTime object
-    @return True if both DateTime objects are the same
-*/
-/**************************************************************************/
-bool DateTime::operator==(const DateTime &right) const
+#if !defined(URTCLIB_NO_RAM)
+/**
+ * \brief Per model RAM window
+ */
+struct uRTCLibRamRegs
 {
-	return unixtime() == right.unixtime();
-}
+	uint8_t start; ///< First RAM register
+	uint8_t size;	///< RAM size, 0 if none
+};
 
-/**************************************************************************/
-/*!
-    @brief  ISO 8601 Timestamp
-    @param opt Format of the timestamp
-    @return Timestamp string, e.g. "2000-01-01T12:34:56"
-*/
-/**************************************************************************/
-String DateTime::timestamp(timestampOpt opt)
+/**
+ * \brief RAM windows, indexed by URTCLIB_MODEL_XXX - 1
+ */
+const uRTCLibRamRegs ramRegs[] PROGMEM = {
+		{0x08, 0x38},	// DS1307: 08h to 3Fh
+		{0x00, 0x00},	// DS3231: no RAM
+		{0x14, 0xEC}}; // DS3232: 14h to FFh
+#endif
+
+/**
+ * \brief Days before each month in a non-leap year, from January; 13th entry is whole year
+ */
+const uint16_t daysBeforeMonth[] PROGMEM = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365};
+
+/**
+ * \brief Converts a decoded time block (see uRTCLibBcd::decodeTimeBlock()) to unixtime, as DateTime::unixtime()
+ *
+ * @param buffer Decoded time block
+ *
+ * @return Unixtime
+ */
+static uint32_t timeBlockToUnix(const uint8_t *buffer)
 {
-	char buffer[20];
+	uint8_t year = buffer[6];
+	uint8_t month = buffer[5] > 12 || buffer[5] == 0 ? 1 : buffer[5]; // corrupt registers must not read past the table
+	uint32_t days = (uint32_t)year * 365 + (year + 3) / 4 + pgm_read_word(daysBeforeMonth + month - 1) + buffer[4] - 1;
 
-	//Generate timestamp according to opt
-	switch (opt)
-	{
-	case TIMESTAMP_TIME:
-		//Only time
-		sprintf(buffer, "%02d:%02d:%02d", hh, mm, ss);
-		break;
-	case TIMESTAMP_DATE:
-		//Only date
-		sprintf(buffer, "%d-%02d-%02d", 2000 + yOff, m, d);
-		break;
-	default:
-		//Full
-		sprintf(buffer, "%d-%02d-%02dT%02d:%02d:%02d", 2000 + yOff, m, d, hh, mm, ss);
-	}
-	return String(buffer);
+	if (month > 2 && year % 4 == 0)
+		days++;
+	return ((days * 24 + buffer[2]) * 60 + buffer[1]) * 60 + buffer[0] + SECONDS_FROM_1970_TO_2000;
 }
 
-/**************************************************************************/
-/*!
-    @brief  Create a new TimeSpan object in seconds
-    @param seconds Number of seconds
-*/
-/**************************************************************************/
-TimeSpan::TimeSpan(int32_t seconds) : _seconds(seconds)
+/************** Register access ****************/
+
+#if defined(URTCLIB_LINUX)
+/**
+ * \brief Default uRTCLibIoctl, the real one
+ */
+static int linuxIoctl(int fd, unsigned long request, void *arg)
 {
+	return ioctl(fd, request, arg);
 }
 
-/**************************************************************************/
-/*!
-    @brief  Create a new TimeSpan object using a number of days/hours/minutes/seconds
-            e.g. Make a TimeSpan of 3 hours and 45 minutes: new TimeSpan(0, 3, 45, 0);
-    @param days Number of days
-    @param hours Number of hours
-    @param minutes Number of minutes
-    @param seconds Number of seconds
-*/
-/**************************************************************************/
-TimeSpan::TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds) : _seconds((int32_t)days * 86400L + (int32_t)hours * 3600 + (int32_t)minutes * 60 + seconds)
+int (*uRTCLibIoctl)(int, unsigned long, void *) = linuxIoctl;
+
+/**
+ * \brief Runs an I2C_RDWR transfer
+ *
+ * @param fd i2c-dev file descriptor
+ * @param transfer Messages to transfer
+ *
+ * @return Wire.endTransmission() like result: 0 success, 2 NACK on address, 4 other error
+ */
+static uint8_t linuxTransfer(const int fd, struct i2c_rdwr_ioctl_data *transfer)
 {
+	if (uRTCLibIoctl(fd, I2C_RDWR, transfer) == (int)transfer->nmsgs)
+	{
+		return 0;
+	}
+	return errno == ENXIO || errno == EREMOTEIO ? 2 : 4;
 }
+#endif
 
-/**************************************************************************/
-/*!
-    @brief  Copy constructor, make a new TimeSpan using an existing one
-    @param copy The TimeSpan to copy
-*/
-/**************************************************************************/
-TimeSpan::TimeSpan(const TimeSpan &copy) : _seconds(copy._seconds)
+/**
+ * \brief Reads consecutive RTC registers in one transaction, no recovery nor locking
+ *
+ * @param reg First register address
+ * @param buffer Destination buffer, at least length bytes. Not modified past received bytes on error
+ * @param length Number of registers to read
+ *
+ * @return 0 on success, Wire.endTransmission() error or #URTCLIB_ERROR_SHORT_READ
+ */
+uint8_t uRTCLib::transferRead(const uint8_t reg, uint8_t *buffer, const uint8_t length)
 {
+	URTCLIB_TRACE_START();
+
+#if defined(URTCLIB_LINUX)
+	// Register pointer write and read in one ioctl, with repeated start
+	uint8_t pointer = reg;
+	struct i2c_msg messages[2] = {
+			{(uint16_t)_rtc_address, 0, 1, &pointer},
+			{(uint16_t)_rtc_address, I2C_M_RD, length, buffer}};
+	struct i2c_rdwr_ioctl_data transfer = {messages, 2};
+	uint8_t result = linuxTransfer(_fd, &transfer);
+	uint8_t received = result == 0 ? length : 0; // I2C_RDWR reads all or fails
+	(void)received;
+#else
+	Wire.beginTransmission(_rtc_address);
+	Wire.write(reg);
+	uint8_t result = Wire.endTransmission();
+
+	uint8_t received = Wire.requestFrom(_rtc_address, (int)length);
+	for (uint8_t i = 0; i < received; i++) // Wire.read(), as readBytes() waits for Stream timeout on short reads
+	{
+		buffer[i] = Wire.read();
+	}
+	if (result == 0 && received != length)
+	{
+		result = URTCLIB_ERROR_SHORT_READ;
+	}
+#endif
+
+	URTCLIB_TRACE_RECORD(_rtc_address, reg, false, buffer, received, result);
+	return result;
 }
 
-/**************************************************************************/
-/*!
-    @brief  Add two TimeSpans
-    @param right TimeSpan to add
-    @return New TimeSpan object, sum of left and right
-*/
-/**************************************************************************/
-TimeSpan TimeSpan::operator+(const TimeSpan &right)
+/**
+ * \brief Writes consecutive RTC registers in one transaction, no recovery nor locking
+ *
+ * @param reg First register address
+ * @param buffer Data to write
+ * @param length Number of registers to write
+ *
+ * @return 0 on success, Wire.endTransmission() error otherwise
+ */
+uint8_t uRTCLib::transferWrite(const uint8_t reg, const uint8_t *buffer, const uint8_t length)
 {
-	return TimeSpan(_seconds + right._seconds);
+	URTCLIB_TRACE_START();
+
+#if defined(URTCLIB_LINUX)
+	uint8_t data[256];
+	data[0] = reg;
+	memcpy(data + 1, buffer, length);
+	struct i2c_msg message = {(uint16_t)_rtc_address, 0, (uint16_t)(length + 1), data};
+	struct i2c_rdwr_ioctl_data transfer = {&message, 1};
+	uint8_t result = linuxTransfer(_fd, &transfer);
+#else
+	Wire.beginTransmission(_rtc_address);
+	Wire.write(reg);
+	Wire.write(buffer, length);
+	uint8_t result = Wire.endTransmission();
+#endif
+
+	URTCLIB_TRACE_RECORD(_rtc_address, reg, true, buffer, length, result);
+	return result;
 }
 
-/**************************************************************************/
-/*!
-    @brief  Subtract a TimeSpan
-    @param right TimeSpan to subtract
-    @return New TimeSpan object, right subtracted from left
-*/
-/**************************************************************************/
-TimeSpan TimeSpan::operator-(const TimeSpan &right)
+/**
+ * \brief Reads consecutive RTC registers in one transaction
+ *
+ * On error bus is recovered, if available, and read is retried once. Not on an address NACK: RTC is missing or busy,
+ * but the bus is not held.
+ *
+ * @param reg First register address
+ * @param buffer Destination buffer, at least length bytes. Not modified past received bytes on error
+ * @param length Number of registers to read
+ *
+ * @return true if all bytes were received
+ */
+bool uRTCLib::registerRead(const uint8_t reg, uint8_t *buffer, const uint8_t length)
 {
-	return TimeSpan(_seconds - right._seconds);
+	uRTCLibLockGuard<URTCLIB_LOCK_POLICY> guard; // register pointer write and read must not be interleaved
+	uint8_t result = transferRead(reg, buffer, length);
+#if defined(URTCLIB_RECOVERY)
+	if (result != 0 && result != 2 && busRecover())
+	{
+		result = transferRead(reg, buffer, length);
+	}
+#endif
+	return result == 0;
 }
 
 /**
- * \brief Constructor
+ * \brief Writes consecutive RTC registers in one transaction
+ *
+ * On error bus is recovered, if available, and write is retried once. Not on an address NACK: RTC is missing or busy,
+ * but the bus is not held.
+ *
+ * @param reg First register address
+ * @param buffer Data to write
+ * @param length Number of registers to write
+ *
+ * @return true if correct
  */
-uRTCLib::uRTCLib() {}
+bool uRTCLib::registerWrite(const uint8_t reg, const uint8_t *buffer, const uint8_t length)
+{
+	uRTCLibLockGuard<URTCLIB_LOCK_POLICY> guard;
+	uint8_t result = transferWrite(reg, buffer, length);
+#if defined(URTCLIB_RECOVERY)
+	if (result != 0 && result != 2 && busRecover())
+	{
+		result = transferWrite(reg, buffer, length);
+	}
+#endif
+	return result == 0;
+}
 
 /**
- * \brief Constructor
+ * \brief Read-modify-write of a single RTC register
  *
- * @param rtc_address I2C address of RTC
+ * @param reg Register address
+ * @param andMask Bits to keep
+ * @param orMask Bits to set
+ *
+ * @return true if correct. Register is not written if read fails
  */
-uRTCLib::uRTCLib(const int rtc_address)
+bool uRTCLib::registerUpdate(const uint8_t reg, const uint8_t andMask, const uint8_t orMask)
 {
-	_rtc_address = rtc_address;
+	uRTCLibLockGuard<URTCLIB_LOCK_POLICY> guard;
+	uint8_t status;
+	if (!registerRead(reg, &status, 1))
+	{
+		return false;
+	}
+	status = (status & andMask) | orMask;
+	return registerWrite(reg, &status, 1);
 }
 
+/**
+ * \brief Reads and decodes the 7-byte time register block in one burst
+ *
+ * Result is also stored in cache and published in time snapshot.
+ *
+ * @param buffer 7 bytes buffer, see uRTCLibBcd::decodeTimeBlock() for resulting contents
+ *
+ * @return true if read was correct
+ */
+bool uRTCLib::readTimeBlock(uint8_t *buffer)
+{
+	uRTCLibLockGuard<URTCLIB_LOCK_POLICY> guard; // one writer at a time for cache and snapshot, in read order
+	bool ok = registerRead(0x00, buffer, 7);
+	uRTCLibBcd::decodeTimeBlock(buffer);
 
-	/**
-	 * \brief Convert binary coded decimal to normal decimal numbers
-	 */
-static uint8_t bcd2bin (uint8_t val) { return val - 6 * (val >> 4); }
+#if !defined(URTCLIB_NO_CACHE)
+	if (ok)
+	{
+		_second = buffer[0];
+		_minute = buffer[1];
+		_hour = buffer[2];
+		_dayOfWeek = buffer[3];
+		_day = buffer[4];
+		_month = buffer[5];
+		_year = buffer[6];
+#if defined(URTCLIB_STALENESS)
+		_refreshMillis = _secondMillis = millis();
+#endif
+	}
+#endif
 
-/**
-	 * \brief Convert normal decimal numbers to binary coded decimal
-	 */
-static uint8_t bin2bcd (uint8_t val) { return val + 6 * (val / 10); }
+#if defined(URTCLIB_SNAPSHOT)
+	uRTCLibTimeSnapshot snapshot;
+	if (ok)
+	{
+		snapshot.unixtime = timeBlockToUnix(buffer);
+		snapshot.flags = URTCLIB_SNAPSHOT_VALID;
+	}
+	else
+	{
+		_snapshot.read(snapshot); // keep last good time
+		snapshot.flags |= URTCLIB_SNAPSHOT_ERROR;
+	}
+	snapshot.stamp = millis();
+	snapshot.millisecond = 0;
+	_snapshot.publish(snapshot);
+#endif
 
+	return ok;
+}
 
 /**
  * \brief Refresh data from HW RTC
  */
 DateTime uRTCLib::now()
 {
+	uint8_t buffer[7] = {0, 0, 0, 0, 1, 1, 0};
 
-	Wire.beginTransmission(_rtc_address);
-	Wire.write((byte)0);
-	Wire.endTransmission();
+	readTimeBlock(buffer);
+
+	return DateTime(buffer[6], buffer[5], buffer[4], buffer[2], buffer[1], buffer[0], buffer[3] - 1); // RTC day of week is 1-7, 1 = Sunday; unset (0) is computed
+}
+
+/**
+ * \brief Reads HW RTC time directly in DateTime::packed() format
+ *
+ * Register fields are shifted into place as read, no DateTime is built. As packed(), saturates from 2064 on.
+ *
+ * @return Current time, packed
+ */
+uint32_t uRTCLib::nowPacked()
+{
+	uint8_t buffer[7] = {0, 0, 0, 0, 1, 1, 0};
+
+	readTimeBlock(buffer);
+
+	if (buffer[6] > 63)
+		return URTCLIB_PACKED_MAX;
+	return ((uint32_t)buffer[6] << 26) | ((uint32_t)buffer[5] << 22) | ((uint32_t)buffer[4] << 17) | ((uint32_t)buffer[2] << 12) | ((uint16_t)buffer[1] << 6) | buffer[0];
+}
+
+/**
+ * \brief Reads HW RTC time directly as unixtime
+ *
+ * Registers are converted with a month table, no DateTime is built. Same as now().unixtime(), so on read error
+ * it returns 2000-01-01 00:00:00.
+ *
+ * @return Current time, seconds since 1970-01-01
+ */
+uint32_t uRTCLib::nowUnix()
+{
+	uint8_t buffer[7] = {0, 0, 0, 0, 1, 1, 0};
 
-	Wire.requestFrom(_rtc_address, 7);
-	uint8_t ss = bcd2bin(Wire.read() & 0x7F);
-	uint8_t mm = bcd2bin(Wire.read());
-	uint8_t hh = bcd2bin(Wire.read());
-	Wire.read();
-	uint8_t d = bcd2bin(Wire.read());
-	uint8_t m = bcd2bin(Wire.read());
-	uint16_t y = bcd2bin(Wire.read()) + 2000;
+	readTimeBlock(buffer);
 
-	return DateTime(y, m, d, hh, mm, ss);
+	return timeBlockToUnix(buffer);
 }
 
 /**
@@ -580,12 +480,8 @@ DateTime uRTCLib::now()
  */
 bool uRTCLib::lostPower()
 {
-	Wire.beginTransmission(_rtc_address);
-	Wire.write(0X0F);
-	Wire.endTransmission();
-
-	Wire.requestFrom(_rtc_address, 1);
-	uint8_t status = Wire.read();
+	uint8_t status = 0;
+	registerRead(0x0F, &status, 1);
 
 	return ((status & 0B10000000) == 0B10000000);
 }
@@ -597,106 +493,194 @@ bool uRTCLib::lostPower()
  */
 void uRTCLib::lostPowerClear()
 {
-	Wire.beginTransmission(_rtc_address);
-	Wire.write(0X0F);
-	Wire.endTransmission();
+	registerUpdate(0x0F, 0b01111111, 0b00000000);
+}
+
+#if !defined(URTCLIB_NO_TEMP)
+/**
+ * \brief Returns actual temperature
+ *
+ * Temperature is returned as degress * 100; i.e.: 3050 is 30.50º
+ *
+ * WARNING: DS1307 has no temperature register, so it always returns #URTCLIB_TEMP_ERROR
+ *
+ * @return Current temperature, read from RTC
+ */
+int16_t uRTCLib::temp()
+{
+	uint8_t buffer[2];
 
-	Wire.requestFrom(_rtc_address, 1);
-	uint8_t status = Wire.read();
-	status &= 0b01111111;
+	if (_model == URTCLIB_MODEL_DS1307 || !registerRead(0x11, buffer, 2))
+	{
+		return URTCLIB_TEMP_ERROR;
+	}
+	return (int8_t) buffer[0] * 100 + (buffer[1] >> 6) * 25; // MSB is signed integer part, LSB bits 7-6 are 0.25 steps
+}
 
-	Wire.beginTransmission(_rtc_address);
+/**
+ * \brief Tells if a temperature conversion is in progress, so temperature registers may be being updated
+ *
+ * Checks both CONV (a conversion started by the user) and BSY (the automatic one, every 64 seconds) bits.
+ *
+ * @return true if converting, or if it cannot be known: DS1307 or a failed read
+ */
+bool uRTCLib::tempConverting()
+{
+	uint8_t buffer[2];
 
-	Wire.write(0x0F);
+	if (_model == URTCLIB_MODEL_DS1307 || !registerRead(0x0E, buffer, 2))
+	{
+		return true;
+	}
+	return (buffer[0] & 0b00100000) || (buffer[1] & 0b00000100); // CONV in control, BSY in status
+}
+#endif
 
-	Wire.write(status);
+#if !defined(URTCLIB_NO_CACHE)
+/**
+ * \brief Refresh cached time from HW RTC, in one burst
+ *
+ * now() and nowPacked() also refresh it.
+ *
+ * @return true if read was correct
+ */
+bool uRTCLib::refresh()
+{
+	uint8_t buffer[7];
 
-	Wire.endTransmission();
+	return readTimeBlock(buffer);
 }
 
+#if defined(URTCLIB_STALENESS)
 /**
- * \brief Returns actual temperature
+ * \brief Sets cached time staleness budget
  *
- * Temperature is returned as degress * 100; i.e.: 3050 is 30.50º
+ * With a budget, getters from second() to dayOfWeek() refresh cached time by themselves, at most once per budget;
+ * in between cached time is advanced by elapsed millis(). So bus traffic is bounded, whatever getters are called.
+ * Cached time may lag RTC by up to 1 second, and consecutive getters may straddle a second change; use now() when
+ * a consistent timestamp is needed. Only built with URTCLIB_STALENESS.
  *
- * WARNING: DS1307 has no temperature register, so it always returns #URTCLIB_TEMP_ERROR
+ * @param ms Max cache age before a refresh, milliseconds. 0 (default) disables it, so refresh() must be called manually
+ */
+void uRTCLib::setStaleness(const uint16_t ms)
+{
+	_staleness = ms;
+	_refreshMillis = millis() - ms; // first getter call refreshes
+}
+
+/**
+ * \brief Advances cached time by elapsed millis(), refreshing it when older than staleness budget
  *
- * @return Current stored temperature
+ * Until a first good read there is no time to advance, cache stays zeroed; the bus is still tried at most once per
+ * budget, so a missing RTC costs one failed transaction per budget.
  */
-int16_t uRTCLib::temp()
+void uRTCLib::cacheUpdate()
 {
-	return _temp;
+	if (!_staleness)
+	{
+		return;
+	}
+
+	uint32_t now = millis();
+	uint32_t elapsed = (now - _secondMillis) / 1000;
+	if (elapsed && _month) // months are 1 to 12, 0 if never read
+	{
+		_secondMillis += elapsed * 1000;
+		DateTime cached(_year, _month, _day, _hour, _minute, _second, _dayOfWeek - 1);
+		cached.addSeconds(elapsed);
+		_second = cached.second();
+		_minute = cached.minute();
+		_hour = cached.hour();
+		_day = cached.day();
+		_month = cached.month();
+		_year = cached.year() - 2000;
+		_dayOfWeek = cached.dayOfTheWeek() + 1;
+	}
+	if (now - _refreshMillis >= _staleness)
+	{
+		_refreshMillis = now; // also on error, so a failing bus is not retried on every call
+		refresh();
+	}
 }
+#endif
 
 /**
  * \brief Returns actual second
  *
- * @return Current stored second
+ * @return Current second, from cache; see setStaleness()
  */
 uint8_t uRTCLib::second()
 {
+	cacheUpdate();
 	return _second;
 }
 
 /**
  * \brief Returns actual minute
  *
- * @return Current stored minute
+ * @return Current minute, from cache; see setStaleness()
  */
 uint8_t uRTCLib::minute()
 {
+	cacheUpdate();
 	return _minute;
 }
 
 /**
  * \brief Returns actual hour
  *
- * @return Current stored hour
+ * @return Current hour, from cache; see setStaleness()
  */
 uint8_t uRTCLib::hour()
 {
+	cacheUpdate();
 	return _hour;
 }
 
 /**
  * \brief Returns actual day
  *
- * @return Current stored day
+ * @return Current day, from cache; see setStaleness()
  */
 uint8_t uRTCLib::day()
 {
+	cacheUpdate();
 	return _day;
 }
 
 /**
  * \brief Returns actual month
  *
- * @return Current stored month
+ * @return Current month, from cache; see setStaleness()
  */
 uint8_t uRTCLib::month()
 {
+	cacheUpdate();
 	return _month;
 }
 
 /**
  * \brief Returns actual year
  *
- * @return Current stored year
+ * @return Current year, from cache; see setStaleness()
  */
 uint8_t uRTCLib::year()
 {
+	cacheUpdate();
 	return _year;
 }
 
 /**
  * \brief Returns actual Day Of Week
  *
- * @return Current stored Day Of Week
+ * @return Current Day Of Week, from cache; see setStaleness()
  */
 uint8_t uRTCLib::dayOfWeek()
 {
+	cacheUpdate();
 	return _dayOfWeek;
 }
+#endif
 
 /**
  * \brief Sets RTC i2 addres
@@ -708,6 +692,109 @@ void uRTCLib::set_rtc_address(const int addr)
 	_rtc_address = addr;
 }
 
+#if defined(URTCLIB_RECOVERY)
+/**
+ * \brief Sets I2C pins used for bus recovery
+ *
+ * Needed when Wire uses other pins than default ones, or when core does not tell them (see #URTCLIB_SDA_PIN).
+ *
+ * @param sda SDA pin, 0xFF disables recovery
+ * @param scl SCL pin, 0xFF disables recovery
+ */
+void uRTCLib::set_bus_pins(const uint8_t sda, const uint8_t scl)
+{
+	_sdaPin = sda;
+	_sclPin = scl;
+}
+
+/**
+ * \brief Releases an I2C bus held by a slave
+ *
+ * A slave reset by nothing while MCU was (i.e. mid-byte on MCU reset) may hold SDA low forever. SCL is clocked,
+ * up to 9 times, until it releases SDA, then a STOP is sent and Wire is started again.
+ *
+ * Called automatically when a register access fails; it can also be called at boot. Wire clock returns to its
+ * default after it, call Wire.setClock() again if another one was in use.
+ *
+ * @return true if bus is free after recovery; false if it is still held or pins are not known
+ */
+bool uRTCLib::busRecover()
+{
+	if (_sdaPin == 0xFF || _sclPin == 0xFF)
+	{
+		return false;
+	}
+
+#if !defined(ARDUINO_ARCH_ESP8266)
+	Wire.end(); // release pins from I2C peripheral
+#endif
+	// Open drain: low is output low, high is released to the bus pull-ups. Output latch is set low before every
+	// pinMode(OUTPUT), as on some cores it keeps its last value, and INPUT_PULLUP sets it high on AVR
+	pinMode(_sdaPin, INPUT);
+	pinMode(_sclPin, INPUT);
+	for (uint8_t i = 0; i < 9 && digitalRead(_sdaPin) == LOW; i++)
+	{
+		digitalWrite(_sclPin, LOW);
+		pinMode(_sclPin, OUTPUT); // SCL low
+		delayMicroseconds(5);
+		pinMode(_sclPin, INPUT); // SCL high, allow slave clock stretching up to 1ms
+		for (uint16_t wait = 0; wait < 200 && digitalRead(_sclPin) == LOW; wait++)
+		{
+			delayMicroseconds(5);
+		}
+		delayMicroseconds(5);
+	}
+
+	// STOP: SDA low to high while SCL is high
+	digitalWrite(_sclPin, LOW);
+	pinMode(_sclPin, OUTPUT); // SCL low
+	digitalWrite(_sdaPin, LOW);
+	pinMode(_sdaPin, OUTPUT); // SDA low
+	delayMicroseconds(5);
+	pinMode(_sclPin, INPUT); // SCL high
+	delayMicroseconds(5);
+	pinMode(_sdaPin, INPUT); // SDA high
+	delayMicroseconds(5);
+	bool free = digitalRead(_sdaPin) == HIGH && digitalRead(_sclPin) == HIGH;
+
+#if defined(ESP32) || defined(ESP8266)
+	Wire.begin(_sdaPin, _sclPin);
+#else
+	Wire.begin();
+#endif
+	return free;
+}
+#endif
+
+/**
+ * \brief Sets RTC Model
+ *
+ * @param model RTC Model, invalid values are ignored:
+ *	 - #URTCLIB_MODEL_DS1307
+ *	 - #URTCLIB_MODEL_DS3231
+ *	 - #URTCLIB_MODEL_DS3232
+ */
+void uRTCLib::set_model(const uint8_t model)
+{
+	if (model >= URTCLIB_MODEL_DS1307 && model <= URTCLIB_MODEL_DS3232)
+	{
+		_model = model;
+	}
+}
+
+/**
+ * \brief Gets RTC Model
+ *
+ * @return RTC Model:
+ *	 - #URTCLIB_MODEL_DS1307
+ *	 - #URTCLIB_MODEL_DS3231
+ *	 - #URTCLIB_MODEL_DS3232
+ */
+uint8_t uRTCLib::model()
+{
+	return _model;
+}
+
 /**
  * \brief Sets RTC datetime data
  *
@@ -721,35 +808,72 @@ void uRTCLib::set_rtc_address(const int addr)
  */
 void uRTCLib::adjust(const DateTime &dt)
 {
+	uint8_t buffer[7];
 
-	Wire.beginTransmission(_rtc_address);
-	Wire.write(0);															 // set next input to start at the seconds register
-	Wire.write(bin2bcd(dt.second));		 // set seconds
-	Wire.write(bin2bcd(dt.minute));		 // set minutes
-	Wire.write(bin2bcd(dt.hour));			 // set hours
-	Wire.write(bin2bcd(0));						 // set day of week (1=Sunday, 7=Saturday)
-	Wire.write(bin2bcd(dt.dayOfMonth)); // set date (1 to 31)
-	Wire.write(bin2bcd(dt.month));			 // set month
-	Wire.write(bin2bcd(dt.year));			 // set year (0 to 99)
-	Wire.endTransmission();
-
-	//
-	Wire.beginTransmission(_rtc_address);
-	Wire.write(0X0F);
-	Wire.endTransmission();
+	buffer[0] = uRTCLibBcd::bin2bcd(dt.second());		 // set seconds
+	buffer[1] = uRTCLibBcd::bin2bcd(dt.minute());		 // set minutes
+	buffer[2] = uRTCLibBcd::bin2bcd(dt.hour());			 // set hours, 24h mode
+	buffer[3] = dt.dayOfTheWeek() + 1;	 // set day of week (1=Sunday, 7=Saturday)
+	buffer[4] = uRTCLibBcd::bin2bcd(dt.day());			 // set date (1 to 31)
+	buffer[5] = uRTCLibBcd::bin2bcd(dt.month()) | (dt.year() >= 2100 ? 0b10000000 : 0); // set month & century
+	buffer[6] = uRTCLibBcd::bin2bcd(dt.year() % 100);	 // set year (0 to 99)
+	registerWrite(0x00, buffer, 7); // start at the seconds register
 
 	/* flip OSF bit --> Disabled, use lostPowerClear instead.
-	Wire.requestFrom(_rtc_address, 1);
-	uint8_t statreg = Wire.read();
-	statreg &= ~0x80;
-	
-	Wire.beginTransmission(_rtc_address);
-	Wire.write(0X0F);
-	Wire.write((byte)statreg);
-	Wire.endTransmission();
+	registerUpdate(0x0F, 0b01111111, 0b00000000);
 	*/
 }
 
+/**
+ * \brief Sets RTC datetime from unixtime, with no DateTime in between
+ *
+ * @param t Seconds since 1970-01-01, from 2000-01-01 on
+ */
+void uRTCLib::adjustUnix(uint32_t t)
+{
+	uint8_t buffer[7];
+
+	t -= SECONDS_FROM_1970_TO_2000;
+	buffer[0] = uRTCLibBcd::bin2bcd(t % 60);
+	t /= 60;
+	buffer[1] = uRTCLibBcd::bin2bcd(t % 60);
+	t /= 60;
+	buffer[2] = uRTCLibBcd::bin2bcd(t % 24);
+	uint16_t days = t / 24;
+	buffer[3] = (days + 6) % 7 + 1; // 1=Sunday; Jan 1, 2000 is a Saturday
+
+	// 4 years cycles of 1461 days, first year is leap (DateTime does not skip 2100 either)
+	uint8_t year = days / 1461 * 4;
+	days %= 1461;
+	bool leap = days < 366;
+	if (!leap)
+	{
+		days -= 366;
+		year += 1 + days / 365;
+		days %= 365;
+	}
+	if (leap && days == 59) // Feb 29th
+	{
+		buffer[4] = 0x29;
+		buffer[5] = 0x02;
+	}
+	else
+	{
+		if (leap && days > 59)
+			days--;
+		// days / 32 is the month or the previous one, as months have 28 to 31 days
+		uint8_t month = days >> 5;
+		if (days >= pgm_read_word(daysBeforeMonth + month + 1))
+			month++;
+		buffer[4] = uRTCLibBcd::bin2bcd(days - pgm_read_word(daysBeforeMonth + month) + 1);
+		buffer[5] = uRTCLibBcd::bin2bcd(month + 1);
+	}
+	buffer[5] |= year >= 100 ? 0b10000000 : 0; // century
+	buffer[6] = uRTCLibBcd::bin2bcd(year % 100);
+	registerWrite(0x00, buffer, 7); // start at the seconds register
+}
+
+#if !defined(URTCLIB_NO_ALARMS)
 /*************  Alarms: ****************/
 
 /**
@@ -780,148 +904,50 @@ void uRTCLib::adjust(const DateTime &dt)
  */
 bool uRTCLib::alarmSet(const uint8_t type, const uint8_t second, const uint8_t minute, const uint8_t hour, const uint8_t day_dow)
 {
-	bool ret = false;
-	uint8_t status;
+	uRTCLibAlarmRegs alarm;
+	uint8_t index = type >> 7;
+	bool ret;
 
-	if (type == URTCLIB_ALARM_TYPE_1_NONE)
+	if (!pgm_read_byte(&alarmModels[_model - 1]))
 	{
-		ret = true;
-
-		// Disable Alarm:
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.endTransmission();
-
-		Wire.requestFrom(_rtc_address, 1);
-		status = Wire.read();
-		status &= 0b11111110;
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.write(status);
-
-		Wire.endTransmission();
-
-		_a1_mode = type;
+		return false;
 	}
-	else if (type == URTCLIB_ALARM_TYPE_2_NONE)
-	{
-		ret = true;
+	memcpy_P(&alarm, &alarmRegs[index], sizeof(alarm));
 
+	uRTCLibLockGuard<URTCLIB_LOCK_POLICY> guard; // alarm registers and control register as a whole
+	if ((type & 0b01111111) == 0) // URTCLIB_ALARM_TYPE_X_NONE
+	{
 		// Disable Alarm:
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.endTransmission();
-
-		Wire.requestFrom(_rtc_address, 1);
-		status = Wire.read();
-		status &= 0b11111101;
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.write(status);
-
-		Wire.endTransmission();
-
-		_a2_mode = type;
+		ret = registerUpdate(0x0E, ~alarm.bit, 0b00000000); // AxIE bit
 	}
 	else
 	{
-		switch (type & 0b10000000)
-		{
-		case 0b00000000: // Alarm 1
-			ret = true;
-			Wire.beginTransmission(_rtc_address);
-
-			Wire.write(0x07); // set next input to start at the seconds register
-
-			Wire.write((bin2bcd(second) & 0b01111111) | ((type & 0b00000001) << 7)); // set seconds & mode/bit1
-
-			Wire.write((bin2bcd(minute) & 0b01111111) | ((type & 0b00000010) << 6)); // set minutes & mode/bit2
-
-			Wire.write((bin2bcd(hour) & 0b00111111) | ((type & 0b00000100) << 5)); // set hours & mode/bit3
-
-			Wire.write((bin2bcd(day_dow) & 0b00111111) | ((type & 0b00001000) << 4) | ((type & 0b00010000) << 2)); // set date / day of week (1=Sunday, 7=Saturday)  & mode/bit4 & mode/DY-DT
-
-			Wire.endTransmission();
-
-			// Enable Alarm:
-			Wire.beginTransmission(_rtc_address);
-
-			Wire.write(0x0E);
-
-			Wire.endTransmission();
-
-			Wire.requestFrom(_rtc_address, 1);
-
-			status = Wire.read();
-			status = status | 0b00000101; // INTCN and A1IE bits
-			Wire.beginTransmission(_rtc_address);
-
-			Wire.write(0x0E);
-
-			Wire.write(status);
-
-			Wire.endTransmission();
-
-			_a1_mode = type;
-			_a1_second = second;
-			_a1_minute = minute;
-			_a1_hour = hour;
-			_a1_day_dow = day_dow;
-			_sqwg_mode = URTCLIB_SQWG_OFF_1;
-
-			break;
-
-		case 0b10000000: // Alarm 2
-			ret = true;
-			Wire.beginTransmission(_rtc_address);
-
-			Wire.write(0x0B); // set next input to start at the minutes register
-
-			Wire.write((bin2bcd(minute) & 0b01111111) | ((type & 0b00000010) << 6)); // set minutes & mode/bit2
-
-			Wire.write((bin2bcd(hour) & 0b00111111) | ((type & 0b00000100) << 5)); // set hours & mode/bit3
-
-			Wire.write((bin2bcd(day_dow) & 0b00111111) | ((type & 0b00001000) << 4) | ((type & 0b00010000) << 2)); // set date / day of week (1=Sunday, 7=Saturday)  & mode/bit4 & mode/DY-DT (bit3)
-
-			Wire.endTransmission();
-
-			// Enable Alarm:
-			Wire.beginTransmission(_rtc_address);
+		const uint8_t values[4] = {second, minute, hour, day_dow};
+		uint8_t buffer[4], length = 0;
 
-			Wire.write(0x0E);
-
-			Wire.endTransmission();
-
-			Wire.requestFrom(_rtc_address, 1);
-
-			status = Wire.read();
-			status = status | 0b00000110; // INTCN and A2IE bits
-			Wire.beginTransmission(_rtc_address);
-
-			Wire.write(0x0E);
-
-			Wire.write(status);
-
-			Wire.endTransmission();
-
-			_a2_mode = type;
-			_a2_minute = minute;
-			_a2_hour = hour;
-			_a2_day_dow = day_dow;
-			_sqwg_mode = URTCLIB_SQWG_OFF_1;
-
-			break;
-		} // Alarm type switch
-
-	} // if..else
+		for (uint8_t field = alarm.firstField; field < 4; field++)
+		{
+			buffer[length++] = (uRTCLibBcd::bin2bcd(values[field]) & (field < 2 ? 0b01111111 : 0b00111111)) | (((type >> field) & 0b00000001) << 7); // value & mode/bit
+		}
+		buffer[length - 1] |= (type & 0b00010000) << 2; // day / day of week (1=Sunday, 7=Saturday) & mode/DY-DT
+		ret = registerWrite(alarm.reg, buffer, length);
+
+		// Enable Alarm:
+		ret = registerUpdate(0x0E, 0b11111111, 0b00000100 | alarm.bit) && ret; // INTCN and AxIE bits
+
+#if !defined(URTCLIB_NO_CACHE)
+		_alarm_second[index] = alarm.firstField ? 0 : second;
+		_alarm_minute[index] = minute;
+		_alarm_hour[index] = hour;
+		_alarm_day_dow[index] = day_dow;
+#if !defined(URTCLIB_NO_SQWG)
+		_sqwg_mode = URTCLIB_SQWG_OFF_1;
+#endif
+#endif
+	}
+#if !defined(URTCLIB_NO_CACHE)
+	_alarm_mode[index] = type;
+#endif
 	return ret;
 }
 
@@ -936,41 +962,8 @@ bool uRTCLib::alarmSet(const uint8_t type, const uint8_t second, const uint8_t m
  */
 bool uRTCLib::alarmDisable(const uint8_t alarm)
 {
-	uint8_t status, mask = 0;
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		mask = 0b11111110;	// A1IE bit
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		mask = 0b11111101;	// A2IE bit
-		break;
-	} // Alarm type switch
-	if (mask)
-	{
-		// Disable Alarm:
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.endTransmission();
-
-		Wire.requestFrom(_rtc_address, 1);
-		status = Wire.read();
-		status &= 0b11111110; // A1IE bit
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.write(status);
-
-		Wire.endTransmission();
-
-		_a1_mode = URTCLIB_ALARM_TYPE_1_NONE;
-		return true;
-	}
-	return false;
+	// URTCLIB_ALARM_X is URTCLIB_ALARM_TYPE_X_NONE
+	return alarmIndex(alarm) < 2 && alarmSet(alarm, 0, 0, 0, 0);
 }
 
 /**
@@ -984,44 +977,122 @@ bool uRTCLib::alarmDisable(const uint8_t alarm)
  */
 bool uRTCLib::alarmClearFlag(const uint8_t alarm)
 {
+	uint8_t index = alarmIndex(alarm);
 
-	uint8_t status, mask = 0;
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		mask = 0b11111110;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		mask = 0b11111101;
-		break;
-
-	} // Alarm type switch
-	if (mask)
+	if (index > 1 || !pgm_read_byte(&alarmModels[_model - 1]))
 	{
-		// Clear Alarm Flag:
-		Wire.beginTransmission(_rtc_address);
+		return false;
+	}
 
-		Wire.write(0x0F);
+	return registerUpdate(0x0F, ~pgm_read_byte(&alarmRegs[index].bit), 0b00000000); // AxF bit
+}
 
-		Wire.endTransmission();
+/**
+ * \brief Works out when an alarm last fired, from its registers
+ *
+ * Latest instant, not after now, matching alarm registers as RTC does: every second or minute, or fixed second,
+ * minute, hour and day of month or day of week. Alarm registers are read as set by alarmSet(), in 24h mode.
+ *
+ * @param alarm #URTCLIB_ALARM_1 or #URTCLIB_ALARM_2
+ * @param now Current RTC time
+ * @param fire Last matching instant
+ *
+ * @return false if not supported (DS1307), wrong parameters or on read error
+ */
+bool uRTCLib::alarmLastFire(const uint8_t alarm, const DateTime &now, DateTime &fire)
+{
+	uRTCLibAlarmRegs regs;
+	uint8_t index = alarmIndex(alarm);
+	uint8_t buffer[4] = {0, 0, 0, 0}; // second (0 on Alarm 2, always matched), minute, hour, day/dow
 
-		Wire.requestFrom(_rtc_address, 1);
-		status = Wire.read();
-		status &= mask; // A?F bit
-		Wire.beginTransmission(_rtc_address);
+	if (index > 1 || !pgm_read_byte(&alarmModels[_model - 1]))
+	{
+		return false;
+	}
+	memcpy_P(&regs, &alarmRegs[index], sizeof(regs));
+	if (!registerRead(regs.reg, buffer + regs.firstField, 4 - regs.firstField))
+	{
+		return false;
+	}
 
-		Wire.write(0x0F);
+	// Fixed fields: from second up to first AxMy mode bit set; period is one unit of next field
+	static const uint32_t periods[4] PROGMEM = {1, 60, 3600, 86400};
+	uint8_t fixed = regs.firstField;
+	while (fixed < 4 && !(buffer[fixed] & 0b10000000))
+	{
+		fixed++;
+	}
+	uint32_t u = now.unixtime();
+	uint32_t target = 0;
+	for (uint8_t field = 0; field < fixed && field < 3; field++)
+	{
+		target += uRTCLibBcd::bcd2bin4(buffer[field] & (field < 2 ? 0b01111111 : 0b00111111)) * pgm_read_dword(&periods[field]);
+	}
 
-		Wire.write(status);
+	if (fixed < 4)
+	{
+		uint32_t period = pgm_read_dword(&periods[fixed]);
+		fire = DateTime(u - (u % period + period - target) % period);
+	}
+	else if (buffer[3] & 0b01000000) // DY: day of week, 1=Sunday
+	{
+		uint32_t inWeek = (u / 86400 + 4) % 7 * 86400 + u % 86400; // Jan 1, 1970 is a Thursday
+		target += (uint32_t)((uRTCLibBcd::bcd2bin4(buffer[3] & 0b00001111) + 6) % 7) * 86400;
+		fire = DateTime(u - (inWeek + 604800 - target) % 604800);
+	}
+	else // DT: day of month, last month having it
+	{
+		uint8_t day = uRTCLibBcd::bcd2bin4(buffer[3] & 0b00111111);
+		uint16_t year = now.year();
+		uint8_t month = now.month();
+		for (uint8_t tries = 0; tries < 12; tries++)
+		{
+			uint32_t midnight = DateTime(year, month, day).unixtime();
+			if (DateTime(midnight).day() == day && midnight + target <= u) // day exists in that month, i.e. no Feb 30th
+			{
+				fire = DateTime(midnight + target);
+				return true;
+			}
+			if (--month == 0)
+			{
+				month = 12;
+				if (year-- == 2000)
+				{
+					return false;
+				}
+			}
+		}
+		return false;
+	}
+	return true;
+}
 
-		Wire.endTransmission();
+/**
+ * \brief Programs an alarm with next match of a cron schedule
+ *
+ * Alarm is set to day of month, hour and minute of next match, so MCU only wakes when a job is due. Call it again
+ * after each alarm. When next match is over a month away alarm may fire on the same day of an earlier month,
+ * so check uRTCLibCron::matches() on wake before running the job.
+ *
+ * @param alarm #URTCLIB_ALARM_1 or #URTCLIB_ALARM_2
+ * @param cron Schedule
+ * @param after Search start, usually now()
+ *
+ * @return false if there is no next match or alarm could not be set
+ */
+bool uRTCLib::alarmSetCron(const uint8_t alarm, const uRTCLibCron &cron, const DateTime &after)
+{
+	DateTime next;
+	uint8_t index = alarmIndex(alarm);
 
-		return true;
+	if (index > 1 || !cron.next(after, next))
+	{
+		return false;
 	}
-	return false;
+	return alarmSet(index ? URTCLIB_ALARM_TYPE_2_FIXED_DHM : URTCLIB_ALARM_TYPE_1_FIXED_DHMS, 0, next.minute(), next.hour(), next.day());
 }
 
+#if !defined(URTCLIB_NO_CACHE)
 /**
  * \brief Returns actual alarm mode.
  *
@@ -1049,18 +1120,8 @@ bool uRTCLib::alarmClearFlag(const uint8_t alarm)
  */
 uint8_t uRTCLib::alarmMode(const uint8_t alarm)
 {
-
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		return _a1_mode;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		return _a2_mode;
-		break;
-	} // Alarm type switch
-	return 0b11111111;
+	uint8_t index = alarmIndex(alarm);
+	return index > 1 ? 0b11111111 : _alarm_mode[index];
 }
 
 /**
@@ -1074,18 +1135,8 @@ uint8_t uRTCLib::alarmMode(const uint8_t alarm)
  */
 uint8_t uRTCLib::alarmSecond(const uint8_t alarm)
 {
-
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		return _a1_second;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		return 0;
-		break;
-	} // Alarm type switch
-	return 0b11111111;
+	uint8_t index = alarmIndex(alarm);
+	return index > 1 ? 0b11111111 : _alarm_second[index];
 }
 
 /**
@@ -1099,18 +1150,8 @@ uint8_t uRTCLib::alarmSecond(const uint8_t alarm)
  */
 uint8_t uRTCLib::alarmMinute(const uint8_t alarm)
 {
-
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		return _a1_minute;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		return _a2_minute;
-		break;
-	} // Alarm type switch
-	return 0b11111111;
+	uint8_t index = alarmIndex(alarm);
+	return index > 1 ? 0b11111111 : _alarm_minute[index];
 }
 
 /**
@@ -1124,18 +1165,8 @@ uint8_t uRTCLib::alarmMinute(const uint8_t alarm)
  */
 uint8_t uRTCLib::alarmHour(const uint8_t alarm)
 {
-
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		return _a1_hour;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		return _a2_hour;
-		break;
-	} // Alarm type switch
-	return 0b11111111;
+	uint8_t index = alarmIndex(alarm);
+	return index > 1 ? 0b11111111 : _alarm_hour[index];
 }
 
 /**
@@ -1149,100 +1180,63 @@ uint8_t uRTCLib::alarmHour(const uint8_t alarm)
  */
 uint8_t uRTCLib::alarmDayDow(const uint8_t alarm)
 {
-
-	switch (alarm)
-	{
-	case URTCLIB_ALARM_1: // Alarm 1
-		return _a1_day_dow;
-		break;
-
-	case URTCLIB_ALARM_2: // Alarm 2
-		return _a2_day_dow;
-		break;
-	} // Alarm type switch
-	return 0b11111111;
+	uint8_t index = alarmIndex(alarm);
+	return index > 1 ? 0b11111111 : _alarm_day_dow[index];
 }
+#endif
+#endif
 
+#if !defined(URTCLIB_NO_SQWG)
 /************** SQuare Wave Generator ****************/
 
 /**
  * \brief Changes SQWG mode, including turning it off
  *
  * @param mode SQWG mode:
- *	 - #URTCLIB_SQWG_OFF_0
+ *	 - #URTCLIB_SQWG_OFF_0 (DS1307 only)
  *	 - #URTCLIB_SQWG_OFF_1
  *	 - #URTCLIB_SQWG_1H
- *	 - #URTCLIB_SQWG_1024H
+ *	 - #URTCLIB_SQWG_1024H (DS3231 and DS3232 only)
  *	 - #URTCLIB_SQWG_4096H
  *	 - #URTCLIB_SQWG_8192H
- *	 - #URTCLIB_SQWG_32768H
+ *	 - #URTCLIB_SQWG_32768H (DS1307 only)
  *
- * @return false in case of not supported (DS1307) or wrong parameters
+ * @return false if current model lacks that mode or on I2C error; cached mode is kept then
  */
 bool uRTCLib::sqwgSetMode(const uint8_t mode)
 {
-	uint8_t status, processAnd = 0b00000000, processOr = 0b00000000;
+	uRTCLibSqwgRegs regs;
+	uRTCLibSqwgBits bits;
 
-	switch (mode)
+	memcpy_P(&regs, &sqwgRegs[_model - 1], sizeof(regs));
+	for (uint8_t i = 0; i < regs.count; i++)
 	{
-	case URTCLIB_SQWG_OFF_1:
-		processAnd = 0b11111111; //  nothing
-		processOr = 0b00000100;	// INTCN
-		break;
-
-	case URTCLIB_SQWG_1H:
-		processAnd = 0b11100011; //  RS1, RS0, INTCN
-		processOr = 0b00000000;	// nothing
-		break;
-
-	case URTCLIB_SQWG_1024H:
-		processAnd = 0b11101011; //  RS1, INTCN
-		processOr = 0b00001000;	// RS0
-		break;
-
-	case URTCLIB_SQWG_4096H:
-		processAnd = 0b11110011; //  RS0, INTCN
-		processOr = 0b00010000;	// RS1
-		break;
-
-	case URTCLIB_SQWG_8192H:
-		processAnd = 0b11111011; //  INTCN
-		processOr = 0b00011000;	//  RS1, RS0
-		break;
-
-	} // mode switch
-
-	if (processAnd || processOr)
-	{ // Any bit change?
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.endTransmission();
-
-		Wire.requestFrom(_rtc_address, 1);
-		status = Wire.read();
-		status = (status & processAnd) | processOr;
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(0x0E);
-
-		Wire.write(status);
-
-		Wire.endTransmission();
-
-		_sqwg_mode = mode;
-		if (mode == URTCLIB_SQWG_OFF_1 || mode == URTCLIB_SQWG_OFF_0)
+		memcpy_P(&bits, &regs.modes[i], sizeof(bits));
+		if (bits.mode == mode)
 		{
-			_a1_mode = URTCLIB_ALARM_TYPE_1_NONE;
-			_a2_mode = URTCLIB_ALARM_TYPE_2_NONE;
+			if (!registerUpdate(regs.reg, bits.andMask, bits.orMask))
+			{
+				return false;
+			}
+
+#if !defined(URTCLIB_NO_CACHE)
+			_sqwg_mode = mode;
+#if !defined(URTCLIB_NO_ALARMS)
+			if (mode == URTCLIB_SQWG_OFF_1 || mode == URTCLIB_SQWG_OFF_0)
+			{
+				_alarm_mode[0] = URTCLIB_ALARM_TYPE_1_NONE;
+				_alarm_mode[1] = URTCLIB_ALARM_TYPE_2_NONE;
+			}
+#endif
+#endif
+			return true;
 		}
-		return true;
 	}
 
 	return false;
 }
 
+#if !defined(URTCLIB_NO_CACHE)
 /**
  * \brief Gets current SQWG mode
  *
@@ -1259,8 +1253,82 @@ uint8_t uRTCLib::sqwgMode()
 {
 	return _sqwg_mode;
 }
+#endif
+#endif
+
+#if !defined(URTCLIB_NO_32KHZ)
+/************** 32KHz output ****************/
+
+/**
+ * \brief Returns 32KHz output status
+ *
+ * WARNING: DS1307 has no 32KHz output, its 32768Hz is set by sqwgSetMode
+ *
+ * @return True if EN32kHz bit is set
+ */
+bool uRTCLib::out32KHz()
+{
+	uint8_t status = 0;
+	registerRead(0x0F, &status, 1);
+
+	return ((status & 0b00001000) == 0b00001000);
+}
+
+/**
+ * \brief Enables or disables 32KHz output
+ *
+ * Alarm flags are written as 1 so they are not cleared, as writing 0 clears them.
+ *
+ * @param enable EN32kHz bit
+ * @param batteryBacked BB32kHz bit, keep output running on VBAT. Only DS3232
+ */
+void uRTCLib::out32KHzSet(const bool enable, const bool batteryBacked)
+{
+	// A2F, A1F written as 1, so they are kept
+	registerUpdate(0x0F, 0b10110111, 0b00000011 | (enable ? 0b00001000 : 0) | (batteryBacked ? 0b01000000 : 0)); // BB32kHz, EN32kHz
+}
+
+/************** 32KHz timebase ****************/
+
+/**
+ * \brief 1Hz SQW edge handler, to be called from ISR
+ *
+ * Seconds whose edges were missed are recovered from 32KHz ticks counted since last edge, rounded to whole
+ * seconds. With no 32KHz pulses at all it just counts seconds.
+ */
+void uRTCLibTimebase::pulse1Hz()
+{
+	uint32_t seconds = (_ticks + 16384) >> 15;
+
+	_unixtime += seconds ? seconds : 1;
+	_ticks = 0;
+}
+
+/**
+ * \brief Gets a consistent timestamp
+ *
+ * Values are re-read until no pulse handler changed them in between, so no interrupt needs to be disabled.
+ * If 1Hz pulses were missed, extra ticks are carried into seconds.
+ *
+ * @param unixtime Output: current second
+ * @param ticks Output: 32KHz ticks since that second started, 0 to 32767
+ */
+void uRTCLibTimebase::stamp(uint32_t &unixtime, uint16_t &ticks)
+{
+	uint32_t allTicks;
+
+	do
+	{
+		unixtime = _unixtime;
+		allTicks = _ticks;
+	} while (unixtime != _unixtime || allTicks != _ticks);
+	unixtime += allTicks >> 15;
+	ticks = allTicks & 0x7FFF;
+}
+#endif
 
-/*** RAM functionality (Only DS1307. Addresses 08h to 3Fh so we offset 08h positions and limit to 38h as maximum address ***/
+#if !defined(URTCLIB_NO_RAM)
+/*** RAM functionality (Only DS1307 and DS3232, see uRTCLib.h) ***/
 
 /**
  * \brief Reads a byte from RTC RAM
@@ -1271,19 +1339,14 @@ uint8_t uRTCLib::sqwgMode()
  */
 byte uRTCLib::ramRead(const uint8_t address)
 {
-	uint8_t offset = 0xff;
+	uRTCLibRamRegs regs;
 
-	if (offset != 0xff)
+	memcpy_P(&regs, &ramRegs[_model - 1], sizeof(regs));
+	if (address < regs.size)
 	{
-		Wire.beginTransmission(_rtc_address);
-
-		Wire.write(address + offset);
-
-		Wire.endTransmission();
-
-		Wire.requestFrom(_rtc_address, 1);
-
-		return Wire.read();
+		uint8_t data = 0xff;
+		registerRead(regs.start + address, &data, 1);
+		return data;
 	}
 	return 0xff;
 }
@@ -1298,21 +1361,895 @@ byte uRTCLib::ramRead(const uint8_t address)
  */
 bool uRTCLib::ramWrite(const uint8_t address, byte data)
 {
-	uint8_t offset = 0xff;
+	uRTCLibRamRegs regs;
 
-	if (offset != 0xff)
+	memcpy_P(&regs, &ramRegs[_model - 1], sizeof(regs));
+	if (address < regs.size)
 	{
-		Wire.beginTransmission(_rtc_address);
+		return registerWrite(regs.start + address, &data, 1);
+	}
+	return false;
+}
+
+/**
+ * \brief Reads consecutive RTC RAM bytes in one transaction
+ *
+ * @param address First RAM Address
+ * @param buffer Destination buffer, at least length bytes
+ * @param length Number of bytes, up to Wire buffer size (32 bytes on AVR)
+ *
+ * @return true if correct; false if any error or range is out of RAM
+ */
+bool uRTCLib::ramRead(const uint8_t address, uint8_t *buffer, const uint8_t length)
+{
+	uRTCLibRamRegs regs;
+
+	memcpy_P(&regs, &ramRegs[_model - 1], sizeof(regs));
+	return address + length <= regs.size && registerRead(regs.start + address, buffer, length);
+}
+
+/**
+ * \brief Writes consecutive RTC RAM bytes in one transaction
+ *
+ * @param address First RAM Address
+ * @param data Content to write from that position
+ * @param length Number of bytes, up to Wire buffer size minus the register address (31 bytes on AVR)
+ *
+ * @return true if correct; false if any error or range is out of RAM
+ */
+bool uRTCLib::ramWrite(const uint8_t address, const uint8_t *data, const uint8_t length)
+{
+	uRTCLibRamRegs regs;
+
+	memcpy_P(&regs, &ramRegs[_model - 1], sizeof(regs));
+	return address + length <= regs.size && registerWrite(regs.start + address, data, length);
+}
+#endif
 
-		Wire.write(address + offset);
+/************** Drift correction ****************/
 
-		Wire.write(data);
+/**
+ * \brief Constructor
+ *
+ * @param rtc RTC to correct
+ * @param threshold Max RTC error allowed before rewriting it, seconds
+ * @param ramAddress Address in RTC RAM (see ramRead()) to store state, #URTCLIB_DRIFT_RAM_SIZE bytes; -1 to not store it
+ */
+uRTCLibDrift::uRTCLibDrift(uRTCLib &rtc, const uint8_t threshold, const int16_t ramAddress) : _rtc(rtc), _threshold(threshold), _ramAddress(ramAddress) {}
 
-		Wire.endTransmission();
+/**
+ * \brief Applies correction to a RTC time
+ *
+ * @param raw RTC unixtime
+ *
+ * @return Corrected unixtime
+ */
+uint32_t uRTCLibDrift::corrected(const uint32_t raw) const
+{
+	int32_t elapsed = raw - _rtcAnchor;
+	return _trueAnchor + elapsed + (int32_t)((int64_t)elapsed * _ppb / 1000000000);
+}
 
+/**
+ * \brief Rewrites RTC if its error is over threshold. State is not saved, callers do it
+ *
+ * @param raw RTC unixtime
+ * @param truth Corrected unixtime
+ *
+ * @return true if RTC was rewritten, so anchor moved
+ */
+bool uRTCLibDrift::rewrite(const uint32_t raw, const uint32_t truth)
+{
+	int32_t error = truth - raw;
+	if (error > _threshold || error < -(int16_t)_threshold)
+	{
+		_rtc.adjust(DateTime(truth));
+		_rtcAnchor += error; // RTC jumped, elapsed RTC seconds since anchor stay the same
 		return true;
 	}
 	return false;
 }
 
+/**
+ * \brief Reads RTC and returns corrected time
+ *
+ * If RTC error is over threshold RTC is set to corrected time. Before first sync() it returns RTC time as is.
+ *
+ * @return Corrected time
+ */
+DateTime uRTCLibDrift::now()
+{
+	DateTime raw = _rtc.now();
+	if (!_anchored)
+	{
+		return raw;
+	}
+
+	uint32_t truth = corrected(raw.unixtime());
+#if !defined(URTCLIB_NO_RAM)
+	if (rewrite(raw.unixtime(), truth))
+	{
+		save();
+	}
+#else
+	rewrite(raw.unixtime(), truth);
+#endif
+	return DateTime(truth);
+}
+
+/**
+ * \brief Syncs with a reference time, learning drift rate
+ *
+ * Error against current correction is spread over time since last sync and added to the rate. Syncs closer than
+ * #URTCLIB_DRIFT_LEARN_SECONDS only correct the offset. RTC is rewritten if its error is over threshold.
+ *
+ * @param reference True current time
+ */
+void uRTCLibDrift::sync(const DateTime &reference)
+{
+	uint32_t raw = _rtc.now().unixtime();
+	int32_t elapsed = raw - _rtcAnchor;
+
+	if (_anchored && elapsed < URTCLIB_DRIFT_LEARN_SECONDS)
+	{
+		// Keep anchor, so learning interval goes on; only the offset is corrected
+		_trueAnchor += reference.unixtime() - corrected(raw);
+	}
+	else
+	{
+		if (_anchored)
+		{
+			_ppb += (int64_t)(int32_t)(reference.unixtime() - corrected(raw)) * 1000000000 / elapsed;
+		}
+		_rtcAnchor = raw;
+		_trueAnchor = reference.unixtime();
+		_anchored = true;
+	}
+	rewrite(raw, reference.unixtime());
+#if !defined(URTCLIB_NO_RAM)
+	save(); // once, with anchor moved by rewrite
+#endif
+}
+
+#if !defined(URTCLIB_NO_RAM)
+/**
+ * \brief Loads state stored by save() from RTC RAM
+ *
+ * @return true if there was a valid state
+ */
+bool uRTCLibDrift::load()
+{
+	uint8_t buffer[URTCLIB_DRIFT_RAM_SIZE];
+
+	if (_ramAddress < 0 || !_rtc.ramRead(_ramAddress, buffer, URTCLIB_DRIFT_RAM_SIZE) || buffer[0] != 0xD5) // magic number
+	{
+		return false;
+	}
+	memcpy(&_rtcAnchor, buffer + 1, 4);
+	memcpy(&_trueAnchor, buffer + 5, 4);
+	memcpy(&_ppb, buffer + 9, 4);
+	_anchored = true;
+	return true;
+}
+
+/**
+ * \brief Stores state in RTC RAM, in one transaction. Called on each sync() and RTC rewrite
+ *
+ * @return true if stored
+ */
+bool uRTCLibDrift::save()
+{
+	uint8_t buffer[URTCLIB_DRIFT_RAM_SIZE];
+
+	if (_ramAddress < 0 || !_anchored)
+	{
+		return false;
+	}
+	buffer[0] = 0xD5; // magic number
+	memcpy(buffer + 1, &_rtcAnchor, 4);
+	memcpy(buffer + 5, &_trueAnchor, 4);
+	memcpy(buffer + 9, &_ppb, 4);
+	return _rtc.ramWrite(_ramAddress, buffer, URTCLIB_DRIFT_RAM_SIZE); // one transaction, so a reset never leaves half a state
+}
+#endif
+
+#if !defined(URTCLIB_NO_RAM) && !defined(URTCLIB_NO_TEMP)
+/************** Temperature history ****************/
+
+/**
+ * \brief Constructor
+ *
+ * @param rtc RTC to sample, DS3232
+ * @param ramAddress Address in RTC RAM (see ramRead()) to store history, #URTCLIB_TEMP_HISTORY_RAM_SIZE bytes
+ */
+uRTCLibTempHistory::uRTCLibTempHistory(uRTCLib &rtc, const uint8_t ramAddress) : _rtc(rtc), _ramAddress(ramAddress) {}
+
+/**
+ * \brief Converts hundredths of Celsius to a stored sample: 0.5C steps from -40C, saturated
+ */
+uint8_t uRTCLibTempHistory::encode(const int16_t temp)
+{
+	int32_t value = ((int32_t) temp + 4025) / 50;
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/**
+ * \brief Loads history from RTC RAM, or starts a new one if there is none
+ *
+ * @return true if there was a stored history
+ */
+bool uRTCLibTempHistory::begin()
+{
+	uint8_t buffer[21];
+
+	if (!_rtc.ramRead(_ramAddress, buffer, 21))
+	{
+		buffer[0] = 0; // no history
+	}
+	if (buffer[0] != 0xA7 || buffer[1] >= URTCLIB_TEMP_HISTORY_HOURS) // magic number
+	{
+		reset();
+		return false;
+	}
+	_head = buffer[1];
+	memcpy(&_last, buffer + 2, 4);
+	_min = buffer[6];
+	_max = buffer[7];
+	memcpy(&_sum, buffer + 8, 4);
+	memcpy(&_count, buffer + 12, 4);
+	memcpy(&_hourSum, buffer + 16, 2);
+	_hourCount = buffer[18];
+	_hourMin = buffer[19];
+	_hourMax = buffer[20];
+	return true;
+}
+
+/**
+ * \brief Clears history, in memory and in RTC RAM
+ */
+void uRTCLibTempHistory::reset()
+{
+	_head = 0;
+	_last = 0;
+	_min = _hourMin = 0xFF;
+	_max = _hourMax = 0;
+	_sum = _count = 0;
+	_hourSum = _hourCount = 0;
+	uint8_t empty[3] = {0xFF, 0, 0xFF}; // min over max
+	for (uint8_t i = 0; i < URTCLIB_TEMP_HISTORY_HOURS; i++)
+	{
+		_rtc.ramWrite(_ramAddress + 21 + 3 * i, empty, 3);
+	}
+	save();
+}
+
+/**
+ * \brief Stores current hour in its bucket and moves to next hour, leaving skipped hours empty
+ *
+ * @param hours Hours elapsed since last sample, at least 1
+ */
+void uRTCLibTempHistory::closeHours(const uint32_t hours)
+{
+	// Only a whole ring of buckets is written, whatever the gap
+	for (uint32_t i = hours > URTCLIB_TEMP_HISTORY_HOURS ? URTCLIB_TEMP_HISTORY_HOURS : hours; i > 0; i--)
+	{
+		// Current hour goes to first bucket, unless it is out of the ring already; skipped hours are empty
+		bool filled = i == hours && _hourCount;
+		uint8_t bucket[3] = {0xFF, 0, 0xFF};
+		if (filled)
+		{
+			bucket[0] = _hourMin;
+			bucket[1] = _hourMax;
+			bucket[2] = (_hourSum + _hourCount / 2) / _hourCount;
+		}
+		_rtc.ramWrite(_ramAddress + 21 + 3 * _head, bucket, 3);
+		_head = (_head + 1) % URTCLIB_TEMP_HISTORY_HOURS;
+	}
+	_hourMin = 0xFF;
+	_hourMax = 0;
+	_hourSum = _hourCount = 0;
+}
+
+/**
+ * \brief Takes a sample if a conversion cycle has passed since last one
+ *
+ * Cheap to call often: if it is not time for a sample there is no bus access. While a temperature conversion is in
+ * progress no sample is taken, next call tries again.
+ *
+ * @param unixtime Current time, i.e. rtc.now().unixtime()
+ *
+ * @return true if a sample was taken
+ */
+bool uRTCLibTempHistory::update(const uint32_t unixtime)
+{
+	if (_count && (int32_t)(unixtime - _last) >= 0 && unixtime - _last < URTCLIB_TEMP_HISTORY_PERIOD)
+	{
+		return false;
+	}
+	if (_rtc.tempConverting())
+	{
+		return false;
+	}
+	int16_t temp = _rtc.temp();
+	if (temp == URTCLIB_TEMP_ERROR)
+	{
+		return false;
+	}
+	uint8_t value = encode(temp);
+
+	if (_count && unixtime / 3600 != _last / 3600)
+	{
+		// New hour; if clock was set back just start a new bucket
+		closeHours(unixtime > _last ? unixtime / 3600 - _last / 3600 : 1);
+	}
+	_hourSum += value;
+	_hourCount++;
+	_hourMin = value < _hourMin ? value : _hourMin;
+	_hourMax = value > _hourMax ? value : _hourMax;
+	_min = value < _min ? value : _min;
+	_max = value > _max ? value : _max;
+	_sum += value;
+	_count++;
+	_last = unixtime;
+	save();
+	return true;
+}
+
+/**
+ * \brief Mean temperature since reset()
+ *
+ * 32-bit arithmetic only: _sum * 50 would overflow after ~330000 samples, so whole and fractional parts are scaled
+ * apart.
+ *
+ * @return Temperature, hundredths of Celsius; #URTCLIB_TEMP_ERROR if there are no samples
+ */
+int16_t uRTCLibTempHistory::mean() const
+{
+	if (!_count)
+	{
+		return URTCLIB_TEMP_ERROR;
+	}
+	uint32_t whole = _sum / _count;
+	return (int16_t)(whole * 50 + (_sum - whole * _count) * 50 / _count) - 4000;
+}
+
+/**
+ * \brief Aggregates of one hour
+ *
+ * @param ago Hours before last sample's hour: 0 is the current one, up to #URTCLIB_TEMP_HISTORY_HOURS
+ * @param min Lowest temperature, hundredths of Celsius
+ * @param max Highest temperature, hundredths of Celsius
+ * @param mean Mean temperature, hundredths of Celsius, with 0.5C resolution
+ *
+ * @return true if that hour has samples
+ */
+bool uRTCLibTempHistory::hour(const uint8_t ago, int16_t &min, int16_t &max, int16_t &mean)
+{
+	uint8_t bucket[3] = {_hourMin, _hourMax, 0xFF};
+
+	if (ago > URTCLIB_TEMP_HISTORY_HOURS)
+	{
+		return false;
+	}
+	if (ago == 0)
+	{
+		if (!_hourCount)
+		{
+			return false;
+		}
+		bucket[2] = (_hourSum + _hourCount / 2) / _hourCount;
+	}
+	else
+	{
+		uint8_t address = _ramAddress + 21 + 3 * ((_head + URTCLIB_TEMP_HISTORY_HOURS - ago) % URTCLIB_TEMP_HISTORY_HOURS);
+		if (!_rtc.ramRead(address, bucket, 3) || bucket[0] > bucket[1])
+		{
+			return false;
+		}
+	}
+	min = decode(bucket[0]);
+	max = decode(bucket[1]);
+	mean = decode(bucket[2]);
+	return true;
+}
+
+/**
+ * \brief Stores header in RTC RAM, in one transaction. Called on each sample
+ *
+ * @return true if stored
+ */
+bool uRTCLibTempHistory::save()
+{
+	uint8_t buffer[21];
+
+	buffer[0] = 0xA7; // magic number
+	buffer[1] = _head;
+	memcpy(buffer + 2, &_last, 4);
+	buffer[6] = _min;
+	buffer[7] = _max;
+	memcpy(buffer + 8, &_sum, 4);
+	memcpy(buffer + 12, &_count, 4);
+	memcpy(buffer + 16, &_hourSum, 2);
+	buffer[18] = _hourCount;
+	buffer[19] = _hourMin;
+	buffer[20] = _hourMax;
+	return _rtc.ramWrite(_ramAddress, buffer, 21);
+}
+#endif
+
+#if !defined(URTCLIB_NO_ALARMS)
+/************** Wake latency ****************/
+
+/**
+ * \brief Constructor
+ *
+ * @param rtc RTC whose alarms wake the MCU
+ */
+uRTCLibWakeProbe::uRTCLibWakeProbe(uRTCLib &rtc) : _rtc(rtc)
+{
+	clear();
+}
+
+/**
+ * \brief Histogram bucket of a latency
+ *
+ * @param us Latency, microseconds
+ *
+ * @return 0 for 0us, b for 2^(b-1) to 2^b - 1 us, saturated at last bucket
+ */
+uint8_t uRTCLibWakeProbe::bucket(uint32_t us)
+{
+	uint8_t b = 0;
+	for (; us && b < URTCLIB_WAKE_BUCKETS - 1; us >>= 1)
+	{
+		b++;
+	}
+	return b;
+}
+
+/**
+ * \brief Acknowledges a wake and records its sample
+ *
+ * Alarm flag is cleared first, as measured chain ends there; then RTC time and alarm registers are read to work out
+ * RTC lag, out of measured times.
+ *
+ * @param source #URTCLIB_ALARM_1 or #URTCLIB_ALARM_2, to clear its flag; #URTCLIB_WAKE_SQW for SQW, nothing to clear
+ *
+ * @return false if alarm flag could not be cleared
+ */
+bool uRTCLibWakeProbe::handled(const uint8_t source)
+{
+	uRTCLibWakeSample sample;
+
+	sample.fell = _fell;
+	sample.woke = _woke;
+	sample.source = source;
+	sample.clearing = micros();
+	sample.ok = source == URTCLIB_WAKE_SQW || _rtc.alarmClearFlag(source);
+	sample.cleared = source == URTCLIB_WAKE_SQW ? sample.clearing : micros();
+
+	sample.rtcLag = source == URTCLIB_WAKE_SQW ? 0 : -1; // SQW falls when RTC second starts
+	if (source != URTCLIB_WAKE_SQW)
+	{
+		DateTime now = _rtc.now(), fire;
+		if (_rtc.alarmLastFire(source, now, fire))
+		{
+			uint32_t lag = now.unixtime() - fire.unixtime();
+			sample.rtcLag = lag > 0x7FFF ? 0x7FFF : lag;
+		}
+	}
+
+	add(sample);
+	if (_log)
+	{
+		print(*_log, sample);
+	}
+	return sample.ok;
+}
+
+/**
+ * \brief Adds a sample to histograms and keeps it as last one
+ *
+ * Used by handled(), and to replay samples logged by setLog() on a host.
+ *
+ * @param sample Sample
+ */
+void uRTCLibWakeProbe::add(const uRTCLibWakeSample &sample)
+{
+	uint8_t b = bucket(sample.cleared - sample.fell);
+	if (_handled[b] < 0xFFFF)
+	{
+		_handled[b]++;
+	}
+	if (sample.source != URTCLIB_WAKE_SQW)
+	{
+		b = bucket(sample.cleared - sample.clearing);
+		if (_i2c[b] < 0xFFFF)
+		{
+			_i2c[b]++;
+		}
+	}
+	_last = sample;
+}
+
+/**
+ * \brief Prints a sample as a CSV line: wake,source,fell,woke,clearing,cleared,ok,rtc_lag
+ *
+ * @param out Output, i.e. Serial
+ * @param sample Sample
+ */
+void uRTCLibWakeProbe::print(Print &out, const uRTCLibWakeSample &sample) const
+{
+	out.print("wake,");
+	out.print((unsigned int)sample.source);
+	out.print(',');
+	out.print((unsigned long)sample.fell);
+	out.print(',');
+	out.print((unsigned long)sample.woke);
+	out.print(',');
+	out.print((unsigned long)sample.clearing);
+	out.print(',');
+	out.print((unsigned long)sample.cleared);
+	out.print(',');
+	out.print((unsigned int)sample.ok);
+	out.print(',');
+	out.print((int)sample.rtcLag);
+	out.println();
+}
+
+/**
+ * \brief Parses a line printed by print()
+ *
+ * @param line CSV line, starting with "wake,"
+ * @param sample Parsed sample
+ *
+ * @return false if line is not a wake sample
+ */
+bool uRTCLibWakeProbe::parse(const char *line, uRTCLibWakeSample &sample)
+{
+	char *end;
+	uint32_t fields[6];
+
+	if (strncmp(line, "wake,", 5))
+	{
+		return false;
+	}
+	line += 5;
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		fields[i] = strtoul(line, &end, 10);
+		if (end == line || *end != ',')
+		{
+			return false;
+		}
+		line = end + 1;
+	}
+	long lag = strtol(line, &end, 10);
+	if (end == line)
+	{
+		return false;
+	}
+	sample.source = fields[0];
+	sample.fell = fields[1];
+	sample.woke = fields[2];
+	sample.clearing = fields[3];
+	sample.cleared = fields[4];
+	sample.ok = fields[5];
+	sample.rtcLag = lag;
+	return true;
+}
+
+/**
+ * \brief Prints histograms as CSV: bucket_us,handled,i2c
+ *
+ * Each bucket holds latencies from its bucket_us to next one's; handled is pin fall to handled, i2c is acknowledge.
+ *
+ * @param out Output, i.e. Serial
+ */
+void uRTCLibWakeProbe::dump(Print &out) const
+{
+	out.println("bucket_us,handled,i2c");
+	for (uint8_t b = 0; b < URTCLIB_WAKE_BUCKETS; b++)
+	{
+		out.print(b ? 1UL << (b - 1) : 0UL);
+		out.print(',');
+		out.print((unsigned int)_handled[b]);
+		out.print(',');
+		out.print((unsigned int)_i2c[b]);
+		out.println();
+	}
+}
+
+/**
+ * \brief Clears histograms
+ */
+void uRTCLibWakeProbe::clear()
+{
+	memset(_handled, 0, sizeof(_handled));
+	memset(_i2c, 0, sizeof(_i2c));
+}
+#endif
+
+#if defined(URTCLIB_LINUX)
+/************** Linux i2c-dev ****************/
+
+/**
+ * \brief Opens I2C bus device
+ *
+ * @param device Bus device, i.e. "/dev/i2c-1"
+ *
+ * @return true if opened
+ */
+bool uRTCLib::i2cOpen(const char *device)
+{
+	i2cClose();
+	_fd = open(device, O_RDWR | O_CLOEXEC);
+	return _fd >= 0;
+}
+
+/**
+ * \brief Uses an already open I2C bus device, shared with other drivers. It will not be closed by i2cClose()
+ *
+ * @param fd i2c-dev file descriptor
+ */
+void uRTCLib::i2cAttach(const int fd)
+{
+	i2cClose();
+	_fd = fd;
+	_fdOwned = false;
+}
+
+/**
+ * \brief Closes I2C bus device opened by i2cOpen()
+ */
+void uRTCLib::i2cClose()
+{
+	if (_fd >= 0 && _fdOwned)
+	{
+		close(_fd);
+	}
+	_fd = -1;
+	_fdOwned = true;
+}
+#endif
+
+/************** Time snapshot ****************/
+
+#if defined(URTCLIB_SNAPSHOT)
+/**
+ * \brief Returns time snapshot, updated on every RTC time read
+ *
+ * @return Snapshot, call its read() to get a consistent copy
+ */
+const uRTCLibSnapshot &uRTCLib::snapshot() const
+{
+	return _snapshot;
+}
+#endif
+
+/**
+ * \brief Constructor, empty snapshot with no flags
+ */
+uRTCLibSnapshot::uRTCLibSnapshot() : _sequence(0)
+{
+	memset(_slots, 0, sizeof(_slots));
+}
+
+/**
+ * \brief Publishes a new snapshot. Only one writer is allowed
+ *
+ * @param snapshot Time to publish
+ */
+void uRTCLibSnapshot::publish(const uRTCLibTimeSnapshot &snapshot)
+{
+	uint32_t next = _sequence + 1;
+	_slots[next & 1] = snapshot; // inactive slot, readers use _sequence & 1
+	URTCLIB_MEMORY_BARRIER();
+	_sequence = next;
+}
+
+/**
+ * \brief Gets a consistent copy of last published snapshot. No I2C access, safe from ISRs
+ *
+ * @param snapshot Destination
+ */
+void uRTCLibSnapshot::read(uRTCLibTimeSnapshot &snapshot) const
+{
+	uint32_t sequence;
+	do
+	{
+		sequence = _sequence;
+		URTCLIB_MEMORY_BARRIER();
+		snapshot = _slots[sequence & 1];
+		URTCLIB_MEMORY_BARRIER();
+	} while (sequence != _sequence); // writer published meanwhile, slot may have been rewritten
+}
+
+/************** Bus lock ****************/
+
+#if defined(ESP32)
+/**
+ * \brief FreeRTOS recursive mutex, created on first use
+ */
+static SemaphoreHandle_t uRTCLibMutex = NULL;
+
+/**
+ * \brief Protects uRTCLibMutex creation
+ */
+static portMUX_TYPE uRTCLibMutexInit = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * \brief Takes the bus mutex, waiting as needed
+ */
+void uRTCLibFreeRTOSLock::lock()
+{
+	if (uRTCLibMutex == NULL)
+	{
+		// Created outside critical section, as allocation is not allowed there
+		SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+		portENTER_CRITICAL(&uRTCLibMutexInit);
+		if (uRTCLibMutex == NULL)
+		{
+			uRTCLibMutex = mutex;
+			mutex = NULL;
+		}
+		portEXIT_CRITICAL(&uRTCLibMutexInit);
+		if (mutex != NULL) // another task created it first
+		{
+			vSemaphoreDelete(mutex);
+		}
+	}
+	xSemaphoreTakeRecursive(uRTCLibMutex, portMAX_DELAY);
+}
+
+/**
+ * \brief Gives the bus mutex back
+ */
+void uRTCLibFreeRTOSLock::unlock()
+{
+	xSemaphoreGiveRecursive(uRTCLibMutex);
+}
+#endif
+
+/************** I2C trace ****************/
+
+#if defined(URTCLIB_TRACE)
+uRTCLibTraceEntry uRTCLibTrace::_entries[URTCLIB_TRACE];
+volatile uint16_t uRTCLibTrace::_head = 0;
+volatile bool uRTCLibTrace::_full = false;
+
+/**
+ * \brief Records a register access, overwriting the oldest entry
+ *
+ * @param address RTC I2C address
+ * @param reg First register
+ * @param write true on writes
+ * @param buffer Bytes transferred
+ * @param length Number of bytes transferred
+ * @param result 0 on success, Wire error or #URTCLIB_ERROR_SHORT_READ
+ * @param duration Transaction duration, microseconds
+ */
+void uRTCLibTrace::record(const uint8_t address, const uint8_t reg, const bool write, const uint8_t *buffer, const uint8_t length, const uint8_t result, const uint32_t duration)
+{
+	uRTCLibTraceEntry &entry = _entries[_head & (URTCLIB_TRACE - 1)];
+	entry.duration = duration > 0xFFFF ? 0xFFFF : duration;
+	entry.address = address;
+	entry.reg = reg;
+	entry.length = length;
+	entry.write = write;
+	entry.result = result;
+	for (uint8_t i = 0; i < URTCLIB_TRACE_DATA; i++)
+	{
+		entry.data[i] = i < length ? buffer[i] : 0;
+	}
+	_head = _head + 1;
+	if (_head == URTCLIB_TRACE)
+	{
+		_full = true;
+	}
+}
+
+/**
+ * \brief Prints stored entries, oldest first, as CSV
+ *
+ * Format: seq,address,reg,dir,length,result,us,data; numbers are decimal but address, reg and data, which are hex.
+ *
+ * @param out Where to print, i.e. Serial
+ */
+void uRTCLibTrace::dump(Print &out)
+{
+	uint16_t head = _head;
+	uint16_t seq = _full ? head - URTCLIB_TRACE : 0;
+
+	out.println("seq,address,reg,dir,length,result,us,data");
+	for (; seq != head; seq++)
+	{
+		const uRTCLibTraceEntry &entry = _entries[seq & (URTCLIB_TRACE - 1)];
+		out.print(seq);
+		out.print(',');
+		out.print(entry.address, HEX);
+		out.print(',');
+		out.print(entry.reg, HEX);
+		out.print(entry.write ? ",W," : ",R,");
+		out.print(entry.length);
+		out.print(',');
+		out.print(entry.result);
+		out.print(',');
+		out.print(entry.duration);
+		out.print(',');
+		for (uint8_t i = 0; i < entry.length && i < URTCLIB_TRACE_DATA; i++)
+		{
+			if (entry.data[i] < 0x10)
+				out.print('0');
+			out.print(entry.data[i], HEX);
+		}
+		out.println();
+	}
+}
+
+/**
+ * \brief Discards all stored entries
+ */
+void uRTCLibTrace::clear()
+{
+	_head = 0;
+	_full = false;
+}
+
+/**
+ * \brief Parses a line printed by dump(), i.e. on a host
+ *
+ * @param line CSV line, header line is rejected
+ * @param seq Where to store sequence number, gaps between lines mean overwritten entries
+ * @param entry Where to store entry
+ *
+ * @return true if line was a valid entry
+ */
+bool uRTCLibTrace::parse(const char *line, uint16_t &seq, uRTCLibTraceEntry &entry)
+{
+	static const uint8_t bases[7] = {10, 16, 16, 0, 10, 10, 10};
+	char *end;
+	uint32_t fields[7];
+
+	for (uint8_t i = 0; i < 7; i++)
+	{
+		if (!bases[i]) // direction
+		{
+			if ((*line != 'R' && *line != 'W') || line[1] != ',')
+			{
+				return false;
+			}
+			fields[i] = *line == 'W';
+			line += 2;
+			continue;
+		}
+		fields[i] = strtoul(line, &end, bases[i]);
+		if (end == line || *end != ',')
+		{
+			return false;
+		}
+		line = end + 1;
+	}
+	memset(entry.data, 0, URTCLIB_TRACE_DATA);
+	for (uint8_t i = 0; i < fields[4] && i < URTCLIB_TRACE_DATA; i++)
+	{
+		char hex[3] = {line[0], line[0] ? line[1] : '\0', '\0'};
+		entry.data[i] = strtoul(hex, &end, 16);
+		if (end != hex + 2)
+		{
+			return false;
+		}
+		line += 2;
+	}
+	seq = fields[0];
+	entry.address = fields[1];
+	entry.reg = fields[2];
+	entry.write = fields[3];
+	entry.length = fields[4];
+	entry.result = fields[5];
+	entry.duration = fields[6];
+	return true;
+}
+#endif
+
 /*** EEPROM functionality has been moved to separate library: https://github.com/Naguissa/uEEPROMLib ***/
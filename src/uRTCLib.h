@@ -28,8 +28,71 @@
 	 * \brief Prevent multiple inclussion
 	 */
 #define URTCLIB
+
+/**
+	 * \brief Linux build, using i2c-dev instead of Wire. Defined when building for Linux outside Arduino
+	 */
+#if defined(__linux__) && !defined(ARDUINO) && !defined(URTCLIB_LINUX)
+#define URTCLIB_LINUX
+#endif
+
+#if defined(URTCLIB_LINUX)
+#include "uRTCLibLinux.h"
+#else
 #include "Arduino.h"
 #include "Wire.h"
+#endif
+
+/************	BUILD CONFIGURATION ***********/
+// Uncomment or define as build flags (-DURTCLIB_NO_ALARMS) to drop unused features, saving flash and RAM.
+// See extras/size_report.sh for each feature cost.
+
+/**
+	 * \brief Removes alarm functions, alarm tables and cached alarm settings
+	 */
+// #define URTCLIB_NO_ALARMS
+
+/**
+	 * \brief Removes SQWG functions and tables
+	 */
+// #define URTCLIB_NO_SQWG
+
+/**
+	 * \brief Removes 32KHz output functions and uRTCLibTimebase
+	 */
+// #define URTCLIB_NO_32KHZ
+
+/**
+	 * \brief Removes RAM functions
+	 */
+// #define URTCLIB_NO_RAM
+
+/**
+	 * \brief Removes temperature function
+	 */
+// #define URTCLIB_NO_TEMP
+
+/**
+	 * \brief Removes cached getters and their fields: second() to dayOfWeek(), alarmMode() to alarmDayDow() and sqwgMode()
+	 */
+// #define URTCLIB_NO_CACHE
+
+/**
+	 * \brief Removes I2C bus-hang recovery, see uRTCLib::busRecover()
+	 */
+// #define URTCLIB_NO_RECOVERY
+
+// Opt-in features, off by default as they add RAM to every uRTCLib object. Uncomment or define as build flags too.
+
+/**
+	 * \brief Publishes every time read to a uRTCLibSnapshot, see uRTCLib::snapshot(); 28 bytes of RAM on AVR
+	 */
+// #define URTCLIB_SNAPSHOT
+
+/**
+	 * \brief Lets second() to dayOfWeek() refresh cached time by themselves, see uRTCLib::setStaleness(); 10 bytes of RAM
+	 */
+// #define URTCLIB_STALENESS
 
 /**
 	 * \brief Default RTC I2C address
@@ -181,6 +244,23 @@
 	 */
 #define URTCLIB_SQWG_32768H 0b00000011
 
+/************	MODELS ***********/
+
+/**
+	 * \brief Model definition, DS1307
+	 */
+#define URTCLIB_MODEL_DS1307 1
+
+/**
+	 * \brief Model definition, DS3231
+	 */
+#define URTCLIB_MODEL_DS3231 2
+
+/**
+	 * \brief Model definition, DS3232
+	 */
+#define URTCLIB_MODEL_DS3232 3
+
 /************	TEMPERATURE ***********/
 /**
 	 * \brief Temperarure read error indicator return value
@@ -199,56 +279,91 @@
 class TimeSpan;
 #define SECONDS_PER_DAY       86400L  ///< 60 * 60 * 24
 #define SECONDS_FROM_1970_TO_2000 946684800  ///< Unixtime for 2000-01-01 00:00:00, useful for initialization
+#define URTCLIB_PACKED_MAX 0xFF3F7EFBUL ///< DateTime::packed() for 2063-12-31 23:59:59, returned for any later time
 
 class DateTime
 {
 public:
 	DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
-	DateTime(uint16_t year, uint8_t month, uint8_t day,
-					 uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
-	DateTime(const DateTime &copy);
-	DateTime(const char *date, const char *time);
+	/*!
+      @brief  DateTime constructor from Y-M-D H:M:S
+      @param year Year, 2 or 4 digits (year 2000 or higher)
+      @param month Month 1-12
+      @param day Day 1-31
+      @param hour 0-23
+      @param min 0-59
+      @param sec 0-59
+      @param dow Day of week 0-6, Sunday is 0, when already known (i.e. read from RTC); any other value computes it from date
+  */
+	constexpr DateTime(uint16_t year, uint8_t month, uint8_t day,
+					 uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0, uint8_t dow = 7)
+			: yOff(year >= 2000 ? year - 2000 : year), m(month), d(day), hh(hour), mm(min), ss(sec),
+				w(dow < 7 ? dow : (date2days(year, month, day) + 6) % 7) {}
+	/*!
+      @brief  DateTime copy constructor, trivial so it stays constexpr along with the implicit assignment
+      @param copy DateTime object to copy
+  */
+	DateTime(const DateTime &copy) = default;
+	/*!
+      @brief  A convenient constructor for using "the compiler's time":
+              constexpr DateTime now (__DATE__, __TIME__);
+              Being constexpr, a constant DateTime is folded at compile time and no string is stored at all.
+      @param date Date string, e.g. "Dec 26 2009"
+      @param time Time string, e.g. "12:34:56"
+  */
+	constexpr DateTime(const char *date, const char *time)
+			: yOff(conv2d(date + 9)), m(conv2month(date)), d(conv2d(date + 4)),
+				hh(conv2d(time)), mm(conv2d(time + 3)), ss(conv2d(time + 6)),
+				w((date2days(conv2d(date + 9), conv2month(date), conv2d(date + 4)) + 6) % 7) {}
 	DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time);
 	char *toString(char *buffer);
 
+	static void toCivil(const uint32_t *src, DateTime *dst, size_t n);
+	static void toUnix(const DateTime *src, uint32_t *dst, size_t n);
+
 	/*!
       @brief  Return the year, stored as an offset from 2000
       @return uint16_t year
   */
-	uint16_t year() const { return 2000 + yOff; }
+	constexpr uint16_t year() const { return 2000 + yOff; }
 	/*!
       @brief  Return month
       @return uint8_t month
   */
-	uint8_t month() const { return m; }
+	constexpr uint8_t month() const { return m; }
 	/*!
       @brief  Return day
       @return uint8_t day
   */
-	uint8_t day() const { return d; }
+	constexpr uint8_t day() const { return d; }
 	/*!
       @brief  Return hours
       @return uint8_t hours
   */
-	uint8_t hour() const { return hh; }
+	constexpr uint8_t hour() const { return hh; }
 	/*!
       @brief  Return minutes
       @return uint8_t minutes
   */
-	uint8_t minute() const { return mm; }
+	constexpr uint8_t minute() const { return mm; }
 	/*!
       @brief  Return seconds
       @return uint8_t seconds
   */
-	uint8_t second() const { return ss; }
+	constexpr uint8_t second() const { return ss; }
 
-	uint8_t dayOfTheWeek() const;
+	/*!
+      @brief  Return the day of the week for this object, from 0-6.
+              Stored, not computed: it comes from the RTC day of week register or is set when the date is built.
+      @return Day of week 0-6 starting with Sunday, e.g. Sunday = 0, Saturday = 6
+  */
+	constexpr uint8_t dayOfTheWeek() const { return w; }
 
 	/** 32-bit times as seconds since 1/1/2000 */
-	long secondstime() const;
+	constexpr long secondstime() const { return time2long(date2days(yOff, m, d), hh, mm, ss); }
 
 	/** 32-bit times as seconds since 1/1/1970 */
-	uint32_t unixtime(void) const;
+	constexpr uint32_t unixtime(void) const { return time2long(date2days(yOff, m, d), hh, mm, ss) + SECONDS_FROM_1970_TO_2000; }
 
 	/** ISO 8601 Timestamp function */
 	enum timestampOpt
@@ -262,32 +377,122 @@ public:
 	DateTime operator+(const TimeSpan &span);
 	DateTime operator-(const TimeSpan &span);
 	TimeSpan operator-(const DateTime &right);
-	bool operator<(const DateTime &right) const;
+	DateTime &operator+=(const TimeSpan &span);
+	DateTime &operator-=(const TimeSpan &span);
+	DateTime &addSeconds(int32_t seconds);
+	DateTime &addDays(int16_t days);
+	DateTime &addMonths(int16_t months);
+	/*!
+      @brief  Is one DateTime object less than (older) than the other?
+      @param right Comparison DateTime object
+      @return True if the left object is older than the right object
+  */
+	constexpr bool operator<(const DateTime &right) const { return unixtime() < right.unixtime(); }
 	/*!
       @brief  Test if one DateTime is greater (later) than another
       @param right DateTime object to compare
       @return True if the left object is greater than the right object, false otherwise
   */
-	bool operator>(const DateTime &right) const { return right < *this; }
+	constexpr bool operator>(const DateTime &right) const { return right < *this; }
 	/*!
       @brief  Test if one DateTime is less (earlier) than or equal to another
       @param right DateTime object to compare
       @return True if the left object is less than or equal to the right object, false otherwise
   */
-	bool operator<=(const DateTime &right) const { return !(*this > right); }
+	constexpr bool operator<=(const DateTime &right) const { return !(*this > right); }
 	/*!
       @brief  Test if one DateTime is greater (later) than or equal to another
       @param right DateTime object to compare
       @return True if the left object is greater than or equal to the right object, false otherwise
   */
-	bool operator>=(const DateTime &right) const { return !(*this < right); }
-	bool operator==(const DateTime &right) const;
+	constexpr bool operator>=(const DateTime &right) const { return !(*this < right); }
+	/*!
+      @brief  Is one DateTime object equal to the other?
+      @param right Comparison DateTime object
+      @return True if both DateTime objects are the same
+  */
+	constexpr bool operator==(const DateTime &right) const { return unixtime() == right.unixtime(); }
 	/*!
       @brief  Test if two DateTime objects not equal
       @param right DateTime object to compare
       @return True if the two objects are not equal, false if they are
   */
-	bool operator!=(const DateTime &right) const { return !(*this == right); }
+	constexpr bool operator!=(const DateTime &right) const { return !(*this == right); }
+
+	/*!
+      @brief  Return the DateTime packed in 32 bits, FAT-style, for dense timestamp arrays
+              Layout from MSB to LSB: year offset (6 bits), month (4), day (5), hour (5), minute (6), second (6).
+              Fields are ordered from most to least significant, so packed values sort and compare
+              chronologically as plain integers. Every bit is used, so the year cannot be widened: it covers
+              2000..2063, and later times saturate to URTCLIB_PACKED_MAX (2063-12-31 23:59:59) so they still
+              sort last instead of wrapping to 2000.
+      @return uint32_t packed DateTime
+  */
+	constexpr uint32_t packed() const
+	{
+		return yOff > 63 ? URTCLIB_PACKED_MAX : ((uint32_t)yOff << 26) | ((uint32_t)m << 22) | ((uint32_t)d << 17) | ((uint32_t)hh << 12) | ((uint16_t)mm << 6) | ss;
+	}
+	/*!
+      @brief  Build a DateTime from its 32 bit packed representation, see packed()
+      @param p Packed DateTime
+      @return DateTime object
+  */
+	static constexpr DateTime unpack(uint32_t p)
+	{
+		return DateTime(p >> 26, (p >> 22) & 0x0F, (p >> 17) & 0x1F, (p >> 12) & 0x1F, (p >> 6) & 0x3F, p & 0x3F);
+	}
+
+	/*!
+      @brief  Convert a string containing two digits to uint8_t, e.g. "09" returns 9
+      @param p Pointer to a string containing two digits
+      @return uint8_t value
+  */
+	static constexpr uint8_t conv2d(const char *p)
+	{
+		return 10 * (('0' <= p[0] && p[0] <= '9') ? p[0] - '0' : 0) + p[1] - '0';
+	}
+	/*!
+      @brief  Convert a 3-letter english month name to its number, e.g. "Dec" returns 12
+      @param p Pointer to a string starting with the month name, as in __DATE__
+      @return uint8_t month 1-12
+  */
+	static constexpr uint8_t conv2month(const char *p)
+	{
+		// Jan Feb Mar Apr May Jun Jul Aug Sep Oct Nov Dec
+		return p[0] == 'J' ? ((p[1] == 'a') ? 1 : ((p[2] == 'n') ? 6 : 7)) :
+					 p[0] == 'F' ? 2 :
+					 p[0] == 'A' ? (p[2] == 'r' ? 4 : 8) :
+					 p[0] == 'M' ? (p[2] == 'r' ? 3 : 5) :
+					 p[0] == 'S' ? 9 :
+					 p[0] == 'O' ? 10 :
+					 p[0] == 'N' ? 11 : 12;
+	}
+	/*!
+      @brief  Given a date, return number of days since 2000/01/01, valid for 2001..2099
+              Days before each month are computed in closed form, (153 * (m - 3) + 2) / 5 from March on,
+              so there is no table to read from PROGMEM and the result can be folded at compile time.
+      @param y Year
+      @param m Month
+      @param d Day
+      @return Number of days
+  */
+	static constexpr uint16_t date2days(uint16_t y, uint8_t m, uint8_t d)
+	{
+		return y >= 2000 ? date2days(y - 2000, m, d) :
+					 d + (m > 2 ? (153 * (m - 3) + 2) / 5 + 59 + (y % 4 == 0) : (m - 1) * 31) + 365 * y + (y + 3) / 4 - 1;
+	}
+	/*!
+      @brief  Given a number of days, hours, minutes, and seconds, return the total seconds
+      @param days Days
+      @param h Hours
+      @param m Minutes
+      @param s Seconds
+      @return Number of seconds total
+  */
+	static constexpr uint32_t time2long(uint16_t days, uint8_t h, uint8_t m, uint8_t s)
+	{
+		return ((days * 24UL + h) * 60 + m) * 60 + s;
+	}
 
 protected:
 	uint8_t yOff; ///< Year offset from 2000
@@ -296,6 +501,7 @@ protected:
 	uint8_t hh;		///< Hours 0-23
 	uint8_t mm;		///< Minutes 0-59
 	uint8_t ss;		///< Seconds 0-59
+	uint8_t w;		///< Day of week 0-6, Sunday is 0 (Jan 1, 2000 is a Saturday, 6)
 };
 
 /**************************************************************************/
@@ -306,50 +512,627 @@ protected:
 class TimeSpan
 {
 public:
-	TimeSpan(int32_t seconds = 0);
-	TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds);
-	TimeSpan(const TimeSpan &copy);
+	/*!
+      @brief  Create a new TimeSpan object in seconds
+      @param seconds Number of seconds
+  */
+	constexpr TimeSpan(int32_t seconds = 0) : _seconds(seconds) {}
+	/*!
+      @brief  Create a new TimeSpan object using a number of days/hours/minutes/seconds
+              e.g. Make a TimeSpan of 3 hours and 45 minutes: new TimeSpan(0, 3, 45, 0);
+      @param days Number of days
+      @param hours Number of hours
+      @param minutes Number of minutes
+      @param seconds Number of seconds
+  */
+	constexpr TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+			: _seconds((int32_t)days * 86400L + (int32_t)hours * 3600 + (int32_t)minutes * 60 + seconds) {}
+	/*!
+      @brief  Copy constructor, make a new TimeSpan using an existing one; trivial, so constexpr
+      @param copy The TimeSpan to copy
+  */
+	TimeSpan(const TimeSpan &copy) = default;
 
 	/*!
       @brief  Number of days in the TimeSpan
               e.g. 4
       @return int16_t days
   */
-	int16_t days() const { return _seconds / 86400L; }
+	constexpr int16_t days() const { return _seconds / 86400L; }
 	/*!
       @brief  Number of hours in the TimeSpan
               This is not the total hours, it includes the days
               e.g. 4 days, 3 hours - NOT 99 hours
       @return int8_t hours
   */
-	int8_t hours() const { return _seconds / 3600 % 24; }
+	constexpr int8_t hours() const { return _seconds / 3600 % 24; }
 	/*!
       @brief  Number of minutes in the TimeSpan
               This is not the total minutes, it includes days/hours
               e.g. 4 days, 3 hours, 27 minutes
       @return int8_t minutes
   */
-	int8_t minutes() const { return _seconds / 60 % 60; }
+	constexpr int8_t minutes() const { return _seconds / 60 % 60; }
 	/*!
       @brief  Number of seconds in the TimeSpan
               This is not the total seconds, it includes the days/hours/minutes
               e.g. 4 days, 3 hours, 27 minutes, 7 seconds
       @return int8_t seconds
   */
-	int8_t seconds() const { return _seconds % 60; }
+	constexpr int8_t seconds() const { return _seconds % 60; }
 	/*!
       @brief  Total number of seconds in the TimeSpan, e.g. 358027
       @return int32_t seconds
   */
-	int32_t totalseconds() const { return _seconds; }
+	constexpr int32_t totalseconds() const { return _seconds; }
 
-	TimeSpan operator+(const TimeSpan &right);
-	TimeSpan operator-(const TimeSpan &right);
+	/*!
+      @brief  Add two TimeSpans
+      @param right TimeSpan to add
+      @return New TimeSpan object, sum of left and right
+  */
+	constexpr TimeSpan operator+(const TimeSpan &right) const { return TimeSpan(_seconds + right._seconds); }
+	/*!
+      @brief  Subtract a TimeSpan
+      @param right TimeSpan to subtract
+      @return New TimeSpan object, right subtracted from left
+  */
+	constexpr TimeSpan operator-(const TimeSpan &right) const { return TimeSpan(_seconds - right._seconds); }
 
 protected:
 	int32_t _seconds; ///< Actual TimeSpan value is stored as seconds
 };
 
+/**************************************************************************/
+/*!
+    @brief  Calendar range of days, ISO weeks (starting on Monday) or months, for range-based for loops:
+              for (DateTime day : DateTimeRange(from, to, DateTimeRange::RANGE_DAYS)) { ... }
+            Each element is the first day of its unit, at 00:00:00, from the unit containing from
+            to the one containing to, both included. It walks backwards when to is before from.
+            Fields are stepped in place, there is no allocation and no full calendar reconversion.
+*/
+/**************************************************************************/
+class DateTimeRange
+{
+public:
+	/** Range step */
+	enum rangeUnit
+	{
+		RANGE_DAYS,	 // Every day
+		RANGE_WEEKS, // Every Monday
+		RANGE_MONTHS // Every first day of month
+	};
+
+	/*!
+      @brief  Range iterator, only meant for range-based for loops
+  */
+	class iterator
+	{
+	public:
+		iterator(const DateTime &start, uint32_t last, rangeUnit unit, int8_t step)
+				: _current(start), _last(last), _unit(unit), _step(step) {}
+		/*!
+          @brief  Current element
+          @return First day of current unit
+      */
+		const DateTime &operator*() const { return _current; }
+		iterator &operator++();
+		/*!
+          @brief  Tells if iteration goes on; end() is only a marker, the last element is stored in every iterator
+          @return True while current element has not passed the last one, nor 2000-01-01 backwards
+      */
+		bool operator!=(const iterator &) const { return _step > 0 ? key(_current) <= _last : _step < 0 && key(_current) >= _last; }
+
+	private:
+		/*!
+          @brief  Date as an ordered key, valid for every DateTime year
+          @param dt DateTime
+          @return Key, comparable as plain integer
+      */
+		static uint32_t key(const DateTime &dt) { return ((uint32_t)(dt.year() - 2000) << 9) | (dt.month() << 5) | dt.day(); }
+
+		DateTime _current; ///< Current element
+		uint32_t _last;		 ///< key() of the last element
+		rangeUnit _unit;	 ///< Step unit
+		int8_t _step;			 ///< +1 forwards, -1 backwards, 0 once a backward walk passed 2000-01-01
+		friend class DateTimeRange;
+	};
+
+	DateTimeRange(const DateTime &from, const DateTime &to, rangeUnit unit = RANGE_DAYS);
+	/*!
+      @brief  First element
+      @return Iterator at the unit containing from
+  */
+	iterator begin() const { return iterator(_first, iterator::key(_last), _unit, _step); }
+	/*!
+      @brief  End marker
+      @return Iterator, only used as operator!= argument
+  */
+	iterator end() const { return iterator(_last, iterator::key(_last), _unit, _step); }
+
+	static DateTime unitStart(const DateTime &dt, rangeUnit unit);
+
+protected:
+	DateTime _first; ///< First day of the unit containing from
+	DateTime _last;	///< First day of the unit containing to
+	rangeUnit _unit; ///< Step unit
+	int8_t _step;		 ///< +1 forwards, -1 backwards
+};
+
+#define URTCLIB_MS_MAX ((int64_t)0x7FFFFFFFFFFFFFFFLL)	///< Largest Instant or Duration, milliseconds
+#define URTCLIB_MS_MIN (-URTCLIB_MS_MAX - 1)						 ///< Smallest Instant or Duration, milliseconds
+
+/**************************************************************************/
+/*!
+    @brief  Signed 64-bit millisecond interval, for spans from milliseconds to centuries.
+            Arithmetic saturates at URTCLIB_MS_MIN and URTCLIB_MS_MAX instead of wrapping.
+            Converts losslessly from TimeSpan; back to TimeSpan the milliseconds are truncated.
+*/
+/**************************************************************************/
+class Duration
+{
+public:
+	/*!
+      @brief  Fields of a Duration, as returned by Duration::split()
+  */
+	struct Parts
+	{
+		bool negative;				 ///< Duration is negative; fields are its magnitude
+		uint32_t days;				 ///< Days, saturated at 0xFFFFFFFF (~11 million years)
+		uint8_t hours;				 ///< Hours 0-23
+		uint8_t minutes;			 ///< Minutes 0-59
+		uint8_t seconds;			 ///< Seconds 0-59
+		uint16_t milliseconds; ///< Milliseconds 0-999
+	};
+
+	/*!
+      @brief  Create a Duration of a number of milliseconds
+      @param ms Milliseconds
+  */
+	explicit constexpr Duration(int64_t ms = 0) : _ms(ms) {}
+	/*!
+      @brief  Create a Duration from a TimeSpan, lossless
+      @param span TimeSpan
+  */
+	constexpr Duration(const TimeSpan &span) : _ms((int64_t)span.totalseconds() * 1000) {}
+
+	/*!
+      @brief  Total milliseconds
+      @return int64_t milliseconds
+  */
+	constexpr int64_t totalMilliseconds() const { return _ms; }
+	TimeSpan toTimeSpan() const;
+	Parts split() const;
+
+	Duration operator+(const Duration &right) const;
+	Duration operator-(const Duration &right) const;
+	Duration operator-() const;
+	/*!
+      @brief  Compare Durations
+      @param right Duration to compare
+      @return True if left is shorter than right
+  */
+	constexpr bool operator<(const Duration &right) const { return _ms < right._ms; }
+	/*!
+      @brief  Compare Durations
+      @param right Duration to compare
+      @return True if left is longer than right
+  */
+	constexpr bool operator>(const Duration &right) const { return _ms > right._ms; }
+	/*!
+      @brief  Compare Durations
+      @param right Duration to compare
+      @return True if both are equal
+  */
+	constexpr bool operator==(const Duration &right) const { return _ms == right._ms; }
+	/*!
+      @brief  Compare Durations
+      @param right Duration to compare
+      @return True if they are different
+  */
+	constexpr bool operator!=(const Duration &right) const { return _ms != right._ms; }
+
+protected:
+	int64_t _ms; ///< Actual Duration value is stored as milliseconds
+};
+
+/**************************************************************************/
+/*!
+    @brief  Point in time with millisecond resolution: signed 64-bit milliseconds since 1970-01-01.
+            Converts losslessly from DateTime plus a millisecond; back to DateTime (valid from 2000
+            to 2106, as DateTime) the milliseconds are dropped.
+*/
+/**************************************************************************/
+class Instant
+{
+public:
+	/*!
+      @brief  Create an Instant from milliseconds since 1970-01-01
+      @param ms Milliseconds since 1970-01-01
+  */
+	explicit constexpr Instant(int64_t ms = (int64_t)SECONDS_FROM_1970_TO_2000 * 1000) : _ms(ms) {}
+	/*!
+      @brief  Create an Instant from a DateTime and a millisecond, lossless
+      @param dt DateTime
+      @param millisecond Millisecond 0-999, i.e. from a uRTCLibTimeSnapshot
+  */
+	constexpr Instant(const DateTime &dt, uint16_t millisecond = 0) : _ms((int64_t)dt.unixtime() * 1000 + millisecond) {}
+
+	/*!
+      @brief  Milliseconds since 1970-01-01
+      @return int64_t milliseconds
+  */
+	constexpr int64_t unixMilliseconds() const { return _ms; }
+	DateTime toDateTime() const;
+	uint16_t millisecond() const;
+
+	Instant operator+(const Duration &span) const;
+	Instant operator-(const Duration &span) const;
+	Duration operator-(const Instant &right) const;
+	/*!
+      @brief  Compare Instants
+      @param right Instant to compare
+      @return True if left is earlier than right
+  */
+	constexpr bool operator<(const Instant &right) const { return _ms < right._ms; }
+	/*!
+      @brief  Compare Instants
+      @param right Instant to compare
+      @return True if left is later than right
+  */
+	constexpr bool operator>(const Instant &right) const { return _ms > right._ms; }
+	/*!
+      @brief  Compare Instants
+      @param right Instant to compare
+      @return True if both are equal
+  */
+	constexpr bool operator==(const Instant &right) const { return _ms == right._ms; }
+	/*!
+      @brief  Compare Instants
+      @param right Instant to compare
+      @return True if they are different
+  */
+	constexpr bool operator!=(const Instant &right) const { return _ms != right._ms; }
+
+protected:
+	int64_t _ms; ///< Milliseconds since 1970-01-01
+};
+
+/************	BCD  ***********/
+
+/**
+ * \brief BCD codec for RTC registers
+ *
+ * Public so benchmarks can compare it with byte at a time decoding; uRTCLib uses it internally.
+ */
+class uRTCLibBcd
+{
+public:
+	/**
+	 * \brief Convert normal decimal numbers to binary coded decimal
+	 */
+	static uint8_t bin2bcd(const uint8_t val) { return val + 6 * (val / 10); }
+	/**
+	 * \brief Convert 4 packed BCD bytes to binary at once (SWAR)
+	 *
+	 * Each byte is hi * 16 + lo, so subtracting 6 * hi on every lane gives hi * 10 + lo.
+	 * No lane can borrow from its neighbour as the result is never negative.
+	 */
+	static uint32_t bcd2bin4(const uint32_t val) { return val - 6 * ((val >> 4) & 0x0F0F0F0FUL); }
+	static void decodeTimeBlock(uint8_t *);
+};
+
+/************	TIMESTAMP STREAMS  ***********/
+
+/**
+	 * \brief Max bytes written by one uRTCLibStampEncoder::encode() or flush() call
+	 */
+#define URTCLIB_STAMP_MAX_BYTES 8
+
+/**
+ * \brief Compact timestamp stream encoder, for event logs and radio packets
+ *
+ * First stamp is stored whole; then each stamp stores its delta-of-delta (change of interval from previous one)
+ * as a zigzag varint, and runs of unchanged intervals are stored as a single run length. So a regular series costs
+ * a few bytes per run and jittery ones 1-2 bytes per stamp, instead of 4.
+ *
+ * Memory is constant (12 bytes), stamps are written as they come. Call flush() before closing a stream, as a run
+ * is only written when it ends. Call reset() to start an independent stream, i.e. on each radio packet.
+ *
+ * Token format: LEB128 varint of value * 2 + tag; tag 0 is a zigzag delta-of-delta (or the first unixtime),
+ * tag 1 is a run of that many stamps with unchanged interval. Arithmetic is modulo 2^32, so any sequence,
+ * even unordered, is lossless.
+ */
+class uRTCLibStampEncoder
+{
+public:
+	uint8_t encode(const uint32_t, uint8_t *);
+	/**
+	 * \brief Encodes a DateTime, see encode(const uint32_t, uint8_t *)
+	 */
+	uint8_t encode(const DateTime &dt, uint8_t *out) { return encode(dt.unixtime(), out); }
+	uint8_t flush(uint8_t *);
+	/**
+	 * \brief Starts a new, independent, stream. Pending run is discarded, call flush() before
+	 */
+	void reset() { _started = false; _run = 0; }
+
+private:
+	uint32_t _last = 0;	// Last stamp
+	uint32_t _delta = 0; // Last interval
+	uint16_t _run = 0;	 // Pending stamps with unchanged interval
+	bool _started = false;
+};
+
+/**
+ * \brief Decoder for uRTCLibStampEncoder streams
+ *
+ * next() decodes one stamp at a time in constant memory, for MCUs; decode() expands a whole stream into an array,
+ * for hosts. DateTime::toCivil() converts decoded unixtimes in bulk.
+ */
+class uRTCLibStampDecoder
+{
+public:
+	uRTCLibStampDecoder(const uint8_t *, const size_t);
+	bool next(uint32_t &);
+	static size_t decode(const uint8_t *, const size_t, uint32_t *, const size_t);
+
+private:
+	const uint8_t *_data;
+	const uint8_t *_end;
+	uint32_t _last = 0;
+	uint32_t _delta = 0;
+	uint16_t _run = 0;
+	bool _started = false;
+};
+
+/************	CRON  ***********/
+
+/**
+ * \brief Cron schedule, compiled to one bitset per field
+ *
+ * Expression is "minute hour day-of-month month day-of-week", i.e. "0-59/15 8-18 * * 1-5". Each field is a comma separated
+ * list of n, a-b, a-b/s or a/s, or * optionally followed by /s ("every s"); numbers only, day of week 0-7 with 0 and 7
+ * being Sunday. As in classic cron, when both day fields are restricted a day matches if any of them does.
+ */
+class uRTCLibCron
+{
+public:
+	uRTCLibCron();
+	uRTCLibCron(const char *);
+	bool parse(const char *);
+	bool matches(const DateTime &) const;
+	bool next(const DateTime &, DateTime &) const;
+
+private:
+	bool dayMatches(const DateTime &) const;
+
+	uint64_t _minutes;	 ///< Bit n: minute n
+	uint32_t _hours;		 ///< Bit n: hour n
+	uint32_t _days;			 ///< Bit n: day of month n
+	uint16_t _months;		 ///< Bit n: month n
+	uint8_t _weekdays;	 ///< Bit n: day of week n, Sunday is 0
+	bool _anyDay;				 ///< Day of month field starts with *
+	bool _anyWeekday;		 ///< Day of week field starts with *
+};
+
+/************	I2C TRACE  ***********/
+
+/**
+	 * \brief Register access result when less bytes than requested were received
+	 *
+	 * Other results are Wire.endTransmission() ones: 0 success, 1 data too long, 2 NACK on address, 3 NACK on data, 4 other error
+	 */
+#define URTCLIB_ERROR_SHORT_READ 0x10
+
+/**
+	 * \brief Enables I2C transaction tracing, value is ring buffer size in entries (power of 2)
+	 *
+	 * Uncomment or define as build flag (-DURTCLIB_TRACE=32) to record every register access.
+	 * When not defined, tracing compiles to nothing.
+	 */
+// #define URTCLIB_TRACE 32
+
+#if defined(URTCLIB_TRACE)
+static_assert(URTCLIB_TRACE > 0 && (URTCLIB_TRACE & (URTCLIB_TRACE - 1)) == 0, "URTCLIB_TRACE must be a power of 2, uint16_t sequence numbers wrap over it");
+
+/**
+	 * \brief Max register bytes stored per trace entry, enough for the time block
+	 */
+#define URTCLIB_TRACE_DATA 7
+
+/**
+ * \brief One traced register access
+ */
+struct uRTCLibTraceEntry
+{
+	uint16_t duration; ///< Transaction duration, microseconds
+	uint8_t address;	 ///< RTC I2C address
+	uint8_t reg;			 ///< First register
+	uint8_t length;		 ///< Bytes transferred
+	bool write;				 ///< true on writes, false on reads
+	uint8_t result;		 ///< 0 on success, Wire error or #URTCLIB_ERROR_SHORT_READ
+	uint8_t data[URTCLIB_TRACE_DATA]; ///< First bytes transferred
+};
+
+/**
+ * \brief Fixed-size ring buffer of the last #URTCLIB_TRACE register accesses
+ *
+ * Single producer (the code using uRTCLib), entries are written before head is advanced, so no locking is needed.
+ * dump() prints entries as CSV; parse() decodes those lines back on a host.
+ */
+class uRTCLibTrace
+{
+public:
+	static void record(const uint8_t, const uint8_t, const bool, const uint8_t *, const uint8_t, const uint8_t, const uint32_t);
+	static void dump(Print &);
+	static void clear();
+	static bool parse(const char *, uint16_t &, uRTCLibTraceEntry &);
+
+private:
+	static uRTCLibTraceEntry _entries[URTCLIB_TRACE];
+	static volatile uint16_t _head;
+	static volatile bool _full;
+};
+
+/**
+	 * \brief Trace start mark, to be used at the beginning of a register access
+	 */
+#define URTCLIB_TRACE_START() uint32_t _traceStart = micros()
+/**
+	 * \brief Trace record, to be used at the end of a register access
+	 */
+#define URTCLIB_TRACE_RECORD(address, reg, write, buffer, length, result) uRTCLibTrace::record(address, reg, write, buffer, length, result, micros() - _traceStart)
+#else
+#define URTCLIB_TRACE_START()
+#define URTCLIB_TRACE_RECORD(address, reg, write, buffer, length, result)
+#endif
+
+#if !defined(URTCLIB_NO_RECOVERY) && !defined(URTCLIB_LINUX)
+/************	BUS RECOVERY  ***********/
+
+/**
+	 * \brief Bus recovery is available: Arduino only, Linux kernel drivers do it by themselves
+	 */
+#define URTCLIB_RECOVERY
+
+/**
+	 * \brief Default I2C pins for bus recovery; 0xFF, disabled, when core does not tell them. See uRTCLib::set_bus_pins()
+	 *
+	 * Both URTCLIB_SDA_PIN and URTCLIB_SCL_PIN can be defined at build time to override them.
+	 */
+#if !defined(URTCLIB_SDA_PIN) && !defined(URTCLIB_SCL_PIN)
+#if defined(PIN_WIRE_SDA) && defined(PIN_WIRE_SCL)
+#define URTCLIB_SDA_PIN PIN_WIRE_SDA
+#define URTCLIB_SCL_PIN PIN_WIRE_SCL
+#elif defined(ESP32) || defined(ESP8266)
+#define URTCLIB_SDA_PIN SDA
+#define URTCLIB_SCL_PIN SCL
+#else
+#define URTCLIB_SDA_PIN 0xFF
+#define URTCLIB_SCL_PIN 0xFF
+#endif
+#endif
+#endif
+
+/************	BUS LOCK  ***********/
+
+/**
+ * \brief Default bus lock policy: no locking, for single-threaded sketches
+ *
+ * A lock policy is any type with static lock() and unlock() functions. It must allow recursive locking,
+ * as multi-step operations lock the bus and then call single register accesses that lock it again.
+ */
+struct uRTCLibNoLock
+{
+	static inline void lock() {}
+	static inline void unlock() {}
+};
+
+/**
+ * \brief Application provided lock policy
+ *
+ * lock() and unlock() are not defined by the library; define them in your sketch, i.e. taking the same mutex
+ * used by other drivers on the bus.
+ */
+struct uRTCLibUserLock
+{
+	static void lock();
+	static void unlock();
+};
+
+#if defined(ESP32)
+/**
+ * \brief FreeRTOS recursive mutex lock policy
+ *
+ * Other code sharing the bus can also call uRTCLibFreeRTOSLock::lock() and unlock() around its own transactions.
+ */
+struct uRTCLibFreeRTOSLock
+{
+	static void lock();
+	static void unlock();
+};
+#endif
+
+/**
+	 * \brief Lock policy used around every register access and multi-step operation
+	 *
+	 * Define as build flag (-DURTCLIB_LOCK_POLICY=uRTCLibFreeRTOSLock or uRTCLibUserLock) when uRTCLib is used from several tasks.
+	 */
+#if !defined(URTCLIB_LOCK_POLICY)
+#define URTCLIB_LOCK_POLICY uRTCLibNoLock
+#endif
+
+/**
+ * \brief Scoped bus lock, locks on construction and unlocks when leaving the scope
+ */
+template <class Policy>
+class uRTCLibLockGuard
+{
+public:
+	uRTCLibLockGuard() { Policy::lock(); }
+	~uRTCLibLockGuard() { Policy::unlock(); }
+
+private:
+	uRTCLibLockGuard(const uRTCLibLockGuard &);
+	uRTCLibLockGuard &operator=(const uRTCLibLockGuard &);
+};
+
+/************	TIME SNAPSHOT  ***********/
+
+/**
+	 * \brief Snapshot flag: time was read from RTC at least once
+	 */
+#define URTCLIB_SNAPSHOT_VALID 0b00000001
+
+/**
+	 * \brief Snapshot flag: last refresh failed, time is the one from last good read
+	 */
+#define URTCLIB_SNAPSHOT_ERROR 0b00000010
+
+/**
+	 * \brief Memory barrier between snapshot data and sequence accesses
+	 *
+	 * A compiler barrier is enough on single-core AVR; other cores (ESP32 dual-core, ARM) get a hardware one.
+	 */
+#if defined(__AVR__)
+#define URTCLIB_MEMORY_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+#define URTCLIB_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+/**
+ * \brief Published time
+ */
+struct uRTCLibTimeSnapshot
+{
+	uint32_t unixtime;		///< Seconds since 1970-01-01 00:00:00
+	uint32_t stamp;				///< millis() when it was published, to know its age
+	uint16_t millisecond; ///< Sub-second part, 0 to 999; 0 when unknown, as on plain RTC reads
+	uint8_t flags;				///< URTCLIB_SNAPSHOT_XXX flags
+};
+
+/**
+ * \brief Time snapshot published by the task owning the RTC, readable from ISRs and other cores with no I2C access
+ *
+ * Double buffer with a sequence counter: publish() writes the inactive slot and then advances the sequence, read()
+ * copies the active slot and retries only if the sequence moved meanwhile. An ISR preempting publish() on the same
+ * core never retries, so it is wait-free there.
+ *
+ * Single writer: only one task may call publish().
+ */
+class uRTCLibSnapshot
+{
+public:
+	uRTCLibSnapshot();
+	void publish(const uRTCLibTimeSnapshot &);
+	void read(uRTCLibTimeSnapshot &) const;
+
+private:
+	uRTCLibTimeSnapshot _slots[2];
+	volatile uint32_t _sequence; // wide enough to never wrap while a reader is preempted
+};
+
 /************	MISC  ***********/
 
 class uRTCLib
@@ -362,6 +1145,13 @@ public:
 
 	/******* RTC functions ********/
 	DateTime now();
+	uint32_t nowPacked();
+	uint32_t nowUnix();
+#if !defined(URTCLIB_NO_CACHE)
+	bool refresh();
+#if defined(URTCLIB_STALENESS)
+	void setStaleness(const uint16_t);
+#endif
 	uint8_t second();
 	uint8_t minute();
 	uint8_t hour();
@@ -369,39 +1159,114 @@ public:
 	uint8_t month();
 	uint8_t year();
 	uint8_t dayOfWeek();
+#endif
+#if !defined(URTCLIB_NO_TEMP)
 	int16_t temp();
+	bool tempConverting();
+#endif
 	void adjust(const DateTime &dt);
+	void adjustUnix(uint32_t);
 	void set_rtc_address(const int);
+	void set_model(const uint8_t);
+#if defined(URTCLIB_RECOVERY)
+	void set_bus_pins(const uint8_t, const uint8_t);
+	bool busRecover();
+#endif
+	uint8_t model();
 
 	/******* Lost power ********/
 	bool lostPower();
 	void lostPowerClear();
 
+#if !defined(URTCLIB_NO_ALARMS)
 	/******** Alarms ************/
 	bool alarmSet(const uint8_t, const uint8_t, const uint8_t, const uint8_t, const uint8_t); // Seconds will be ignored on Alarm 2
 	bool alarmDisable(const uint8_t);
 	bool alarmClearFlag(const uint8_t);
+	bool alarmSetCron(const uint8_t, const uRTCLibCron &, const DateTime &);
+	bool alarmLastFire(const uint8_t, const DateTime &, DateTime &);
+#if !defined(URTCLIB_NO_CACHE)
 	uint8_t alarmMode(const uint8_t);
 	uint8_t alarmSecond(const uint8_t);
 	uint8_t alarmMinute(const uint8_t);
 	uint8_t alarmHour(const uint8_t);
 	uint8_t alarmDayDow(const uint8_t);
+#endif
+#endif
 
+#if !defined(URTCLIB_NO_SQWG)
 	/*********** SQWG ************/
+#if !defined(URTCLIB_NO_CACHE)
 	uint8_t sqwgMode();
+#endif
 	bool sqwgSetMode(const uint8_t);
+#endif
 
+#if !defined(URTCLIB_NO_32KHZ)
+	/*********** 32KHz ************/
+	// Only DS3231 and DS3232.
+	bool out32KHz();
+	void out32KHzSet(const bool, const bool = false);
+#endif
+
+#if !defined(URTCLIB_NO_RAM)
 	/************ RAM *************/
 	// Only DS1307 and DS3232.
 	// DS1307: Addresses 08h to 3Fh so we offset 08h positions and limit to 38h as maximum address
 	// DS3232: Addresses 14h to FFh so we offset 14h positions and limit to EBh as maximum address
 	byte ramRead(const uint8_t);
 	bool ramWrite(const uint8_t, byte);
+	bool ramRead(const uint8_t, uint8_t *, const uint8_t);
+	bool ramWrite(const uint8_t, const uint8_t *, const uint8_t);
+#endif
+
+#if defined(URTCLIB_SNAPSHOT)
+	/********* Snapshot **********/
+	// Published on every now() and nowPacked(), safe to read from ISRs
+	const uRTCLibSnapshot &snapshot() const;
+#endif
+
+#if defined(URTCLIB_LINUX)
+	/********* Linux i2c-dev **********/
+	bool i2cOpen(const char *);
+	void i2cAttach(const int);
+	void i2cClose();
+#endif
 
 private:
+	bool registerRead(const uint8_t, uint8_t *, const uint8_t);
+	bool registerWrite(const uint8_t, const uint8_t *, const uint8_t);
+	bool registerUpdate(const uint8_t, const uint8_t, const uint8_t);
+	uint8_t transferRead(const uint8_t, uint8_t *, const uint8_t);
+	uint8_t transferWrite(const uint8_t, const uint8_t *, const uint8_t);
+	bool readTimeBlock(uint8_t *);
+#if defined(URTCLIB_STALENESS) && !defined(URTCLIB_NO_CACHE)
+	void cacheUpdate();
+#elif !defined(URTCLIB_NO_CACHE)
+	void cacheUpdate() {}
+#endif
+
 	// Address
 	int _rtc_address = URTCLIB_ADDRESS;
-	// RTC rad data
+	// Model
+	uint8_t _model = URTCLIB_MODEL_DS3232;
+#if defined(URTCLIB_RECOVERY)
+	// I2C pins, for bus recovery
+	uint8_t _sdaPin = URTCLIB_SDA_PIN;
+	uint8_t _sclPin = URTCLIB_SCL_PIN;
+#endif
+#if defined(URTCLIB_LINUX)
+	// i2c-dev file descriptor
+	int _fd = -1;
+	bool _fdOwned = true;
+#endif
+#if defined(URTCLIB_SNAPSHOT)
+	// Last time read
+	uRTCLibSnapshot _snapshot;
+#endif
+
+#if !defined(URTCLIB_NO_CACHE)
+	// RTC rad data, refreshed on each time read
 	uint8_t _second = 0;
 	uint8_t _minute = 0;
 	uint8_t _hour = 0;
@@ -409,22 +1274,307 @@ private:
 	uint8_t _month = 0;
 	uint8_t _year = 0;
 	uint8_t _dayOfWeek = 0;
-	int16_t _temp = 9999;
-
-	// Alarms:
-	uint8_t _a1_mode = URTCLIB_ALARM_TYPE_1_NONE;
-	uint8_t _a1_second = 0;
-	uint8_t _a1_minute = 0;
-	uint8_t _a1_hour = 0;
-	uint8_t _a1_day_dow = 0;
+#if defined(URTCLIB_STALENESS)
+	// Staleness budget, ms; 0 for manual refresh()
+	uint16_t _staleness = 0;
+	// millis() at last time read and at start of cached second
+	uint32_t _refreshMillis = 0;
+	uint32_t _secondMillis = 0;
+#endif
 
-	uint8_t _a2_mode = URTCLIB_ALARM_TYPE_2_NONE;
-	uint8_t _a2_minute = 0;
-	uint8_t _a2_hour = 0;
-	uint8_t _a2_day_dow = 0;
+#if !defined(URTCLIB_NO_ALARMS)
+	// Alarms, Alarm 1 and Alarm 2:
+	uint8_t _alarm_mode[2] = {URTCLIB_ALARM_TYPE_1_NONE, URTCLIB_ALARM_TYPE_2_NONE};
+	uint8_t _alarm_second[2] = {0, 0};
+	uint8_t _alarm_minute[2] = {0, 0};
+	uint8_t _alarm_hour[2] = {0, 0};
+	uint8_t _alarm_day_dow[2] = {0, 0};
+#endif
 
+#if !defined(URTCLIB_NO_SQWG)
 	// SQWG
 	uint8_t _sqwg_mode = URTCLIB_SQWG_OFF_1;
+#endif
+#endif
 };
 
+#if !defined(URTCLIB_NO_32KHZ)
+/************	32KHz TIMEBASE  ***********/
+
+/**
+ * \brief High resolution timebase from the RTC 32KHz and 1Hz SQW outputs
+ *
+ * DS3231 and DS3232 32KHz output is temperature compensated, so counting its edges
+ * between 1Hz SQW boundaries timestamps events with 1/32768s (~30.5us) resolution
+ * and RTC accuracy, regardless of MCU crystal drift.
+ *
+ * Wiring and usage:
+ *     * Enable outputs: rtc.out32KHzSet(true); rtc.sqwgSetMode(URTCLIB_SQWG_1H);
+ *     * Attach pulse32KHz() to 32K pin edges (or feed it from a hardware counter, passing the counted edges)
+ *     * Attach pulse1Hz() to SQW pin falling edge, when seconds register increments
+ *     * Call sync() with rtc.now().unixtime() once, just after a 1Hz edge
+ *     * Call stamp() to timestamp an event, from main code or ISRs
+ *
+ * Missed 1Hz edges are recovered from 32KHz ticks, which count up to 2^32 (over 36 hours) without a 1Hz edge.
+ */
+class uRTCLibTimebase
+{
+public:
+	/**
+	 * \brief Sets current second, as read from RTC
+	 *
+	 * @param unixtime Unixtime of the second started at last 1Hz edge
+	 */
+	void sync(const uint32_t unixtime) { _unixtime = unixtime; }
+	/**
+	 * \brief 32KHz edge handler, to be called from ISR
+	 *
+	 * @param count Edges counted since last call, for hardware counters
+	 */
+	void pulse32KHz(const uint16_t count = 1) { _ticks += count; }
+	void pulse1Hz();
+	void stamp(uint32_t &, uint16_t &);
+	/**
+	 * \brief Converts 32KHz ticks to microseconds
+	 *
+	 * @param ticks 32KHz ticks, 0 to 32767
+	 *
+	 * @return Microseconds, as 1000000 / 32768 is 15625 / 512
+	 */
+	static uint32_t ticksToMicros(const uint16_t ticks) { return ((uint32_t) ticks * 15625) >> 9; }
+
+private:
+	volatile uint32_t _unixtime = 0;
+	volatile uint32_t _ticks = 0; // 32KHz edges since last 1Hz one; 16 bits would only cover one missed edge
+};
+#endif
+
+/************	DRIFT CORRECTION  ***********/
+
+/**
+	 * \brief Minimum time between syncs to learn drift rate, seconds
+	 *
+	 * Syncs have 1s resolution, so 1 day gives ~12ppm resolution. Closer syncs only correct the offset.
+	 */
+#define URTCLIB_DRIFT_LEARN_SECONDS 86400
+
+/**
+	 * \brief Bytes used in RTC RAM to store drift state
+	 */
+#define URTCLIB_DRIFT_RAM_SIZE 13
+
+/**
+ * \brief Software drift correction, for RTCs with no aging register (DS1307)
+ *
+ * Keeps an anchor (RTC time and true time at last sync) and a learned rate. Every now() returns RTC time corrected
+ * linearly from the anchor; RTC is only rewritten when its error goes over a threshold, so there are no constant
+ * adjust() writes. Each sync() with a reference time (NTP, GPS...) refines the rate from the error found.
+ *
+ * State can be kept in RTC RAM, so learned rate survives MCU resets.
+ */
+class uRTCLibDrift
+{
+public:
+	uRTCLibDrift(uRTCLib &, const uint8_t = 2, const int16_t = -1);
+	DateTime now();
+	void sync(const DateTime &);
+	/**
+	 * \brief Learned rate, RTC seconds are multiplied by 1 + ppb / 10^9
+	 *
+	 * It also absorbs the sub-second part lost on each RTC rewrite, as RTC time is only read to the second.
+	 *
+	 * @return Rate, parts per billion; positive when RTC is slow
+	 */
+	int32_t ppb() const { return _ppb; }
+	/**
+	 * \brief Sets rate, i.e. a known one from a previous calibration
+	 *
+	 * @param ppb Rate, parts per billion; positive when RTC is slow
+	 */
+	void setPpb(const int32_t ppb) { _ppb = ppb; }
+#if !defined(URTCLIB_NO_RAM)
+	bool load();
+	bool save();
+#endif
+
+private:
+	uint32_t corrected(const uint32_t) const;
+	bool rewrite(const uint32_t, const uint32_t);
+
+	uRTCLib &_rtc;
+	uint32_t _rtcAnchor = 0;	 // RTC unixtime at last sync, moved along with RTC rewrites
+	uint32_t _trueAnchor = 0;	// True unixtime at last sync
+	int32_t _ppb = 0;
+	uint8_t _threshold;				// Max RTC error, seconds
+	int16_t _ramAddress;			 // State address in RTC RAM, -1 if not stored
+	bool _anchored = false;
+};
+
+#if !defined(URTCLIB_NO_RAM) && !defined(URTCLIB_NO_TEMP)
+/************	TEMPERATURE HISTORY  ***********/
+
+/**
+	 * \brief Seconds between temperature samples, as DS3231 and DS3232 convert temperature every 64 seconds
+	 */
+#define URTCLIB_TEMP_HISTORY_PERIOD 64
+
+/**
+	 * \brief Hourly buckets kept in RTC RAM
+	 */
+#define URTCLIB_TEMP_HISTORY_HOURS 24
+
+/**
+	 * \brief Bytes used in RTC RAM by temperature history: 21 header bytes plus 3 per hourly bucket
+	 */
+#define URTCLIB_TEMP_HISTORY_RAM_SIZE (21 + 3 * URTCLIB_TEMP_HISTORY_HOURS)
+
+/**
+ * \brief Temperature history, for DS3232
+ *
+ * Samples temp() once per conversion cycle, never while one is in progress, and keeps min, max and mean since reset()
+ * plus min, max and mean of the last #URTCLIB_TEMP_HISTORY_HOURS hours. Each sample updates them in constant time;
+ * no raw samples are kept.
+ *
+ * Everything is stored in RTC RAM, so history survives MCU resets: call begin() on startup and update() from loop.
+ * Samples are stored with 0.5C resolution, from -40C to 87.5C. Temperatures are in hundredths of Celsius, as temp().
+ */
+class uRTCLibTempHistory
+{
+public:
+	uRTCLibTempHistory(uRTCLib &, const uint8_t);
+	bool begin();
+	void reset();
+	bool update(const uint32_t);
+	bool hour(const uint8_t, int16_t &, int16_t &, int16_t &);
+	/**
+	 * \brief Lowest temperature since reset()
+	 *
+	 * @return Temperature, hundredths of Celsius; #URTCLIB_TEMP_ERROR if there are no samples
+	 */
+	int16_t min() const { return _count ? decode(_min) : URTCLIB_TEMP_ERROR; }
+	/**
+	 * \brief Highest temperature since reset()
+	 *
+	 * @return Temperature, hundredths of Celsius; #URTCLIB_TEMP_ERROR if there are no samples
+	 */
+	int16_t max() const { return _count ? decode(_max) : URTCLIB_TEMP_ERROR; }
+	int16_t mean() const;
+	/**
+	 * \brief Samples taken since reset()
+	 *
+	 * @return Number of samples
+	 */
+	uint32_t samples() const { return _count; }
+
+private:
+	static uint8_t encode(const int16_t);
+	/**
+	 * \brief Converts a stored sample to hundredths of Celsius
+	 */
+	static int16_t decode(const uint8_t value) { return (int16_t) value * 50 - 4000; }
+	void closeHours(const uint32_t);
+	bool save();
+
+	uRTCLib &_rtc;
+	uint8_t _ramAddress;
+	// Header, same order as in RTC RAM
+	uint8_t _head = 0;					// Next bucket to write
+	uint32_t _last = 0;				 // Unixtime of last sample
+	uint8_t _min = 0xFF;
+	uint8_t _max = 0;
+	uint32_t _sum = 0;
+	uint32_t _count = 0;
+	uint16_t _hourSum = 0;			// Current hour aggregates
+	uint8_t _hourCount = 0;
+	uint8_t _hourMin = 0xFF;
+	uint8_t _hourMax = 0;
+};
+#endif
+
+#if !defined(URTCLIB_NO_ALARMS)
+/************	WAKE LATENCY  ***********/
+
+/**
+	 * \brief Wake source for 1Hz SQW interrupts, see uRTCLibWakeProbe::handled()
+	 */
+#define URTCLIB_WAKE_SQW 0xFF
+
+/**
+	 * \brief Latency histogram buckets: 0, then powers of 2 microseconds; last one also holds longer latencies (8.4s+)
+	 */
+#define URTCLIB_WAKE_BUCKETS 24
+
+/**
+ * \brief One measured wake, all times are micros()
+ */
+struct uRTCLibWakeSample
+{
+	uint32_t fell;		 ///< INT/SQW pin falling edge, from pinFell()
+	uint32_t woke;		 ///< MCU resumed, from woke()
+	uint32_t clearing; ///< Before acknowledging alarm flag
+	uint32_t cleared;	///< After acknowledging it, so wake is handled
+	int16_t rtcLag;		 ///< RTC seconds from alarm fire instant to acknowledge; -1 if unknown
+	uint8_t source;		 ///< #URTCLIB_ALARM_1, #URTCLIB_ALARM_2 or #URTCLIB_WAKE_SQW
+	bool ok;					 ///< Alarm flag was cleared
+};
+
+/**
+ * \brief Wake latency instrumentation for alarm and SQW interrupts
+ *
+ * Timestamps the chain "alarm fires, INT pin falls, MCU wakes, alarm flag is cleared" and keeps two histograms:
+ * pin fall to handled (whole wake) and I2C time spent acknowledging. Alarm fire instant is worked out from alarm
+ * registers, so late or missed wakes show up as RTC lag.
+ *
+ * Usage:
+ *     * Call pinFell() first thing in the INT/SQW pin ISR
+ *     * Call woke() first thing after sleep returns
+ *     * Call handled(alarm) instead of rtc.alarmClearFlag(alarm); handled(URTCLIB_WAKE_SQW) for SQW
+ *
+ * For sleep modes keeping RAM and micros() (AVR power-down, ESP32 light sleep); deep sleeps resetting MCU can't be
+ * measured this way. setLog() prints each sample as a "wake," CSV line; parse() and add() replay them on a host.
+ */
+class uRTCLibWakeProbe
+{
+public:
+	uRTCLibWakeProbe(uRTCLib &);
+	/**
+	 * \brief INT/SQW pin falling edge, to be called from ISR
+	 *
+	 * INT pin stays low until alarm flag is cleared, so there is no new edge while handled() reads it.
+	 */
+	void pinFell() { _fell = micros(); }
+	/**
+	 * \brief MCU resumed from sleep
+	 */
+	void woke() { _woke = micros(); }
+	bool handled(const uint8_t);
+	void add(const uRTCLibWakeSample &);
+	/**
+	 * \brief Prints every new sample, as a "wake," CSV line
+	 *
+	 * @param log Output, i.e. &Serial; 0 (default) disables it
+	 */
+	void setLog(Print *log) { _log = log; }
+	/**
+	 * \brief Last sample
+	 */
+	const uRTCLibWakeSample &last() const { return _last; }
+	void print(Print &, const uRTCLibWakeSample &) const;
+	static bool parse(const char *, uRTCLibWakeSample &);
+	void dump(Print &) const;
+	void clear();
+
+private:
+	static uint8_t bucket(uint32_t);
+
+	uRTCLib &_rtc;
+	Print *_log = 0;
+	volatile uint32_t _fell = 0;
+	uint32_t _woke = 0;
+	uRTCLibWakeSample _last = {0, 0, 0, 0, -1, URTCLIB_WAKE_SQW, false};
+	uint16_t _handled[URTCLIB_WAKE_BUCKETS]; // pin fall to handled
+	uint16_t _i2c[URTCLIB_WAKE_BUCKETS];		 // acknowledge
+};
+#endif
+
 #endif
@@ -0,0 +1,1219 @@
+/**
+ * \brief DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Date and time core: DateTime, TimeSpan, DateTimeRange, Instant, Duration, timestamp streams and uRTCLibCron.
+ * No RTC nor I2C code, so it also builds alone on other platforms, through uRTCLibLinux.h.
+ *
+ * @file uRTCLibDateTime.cpp
+ * @copyright Naguissa
+ * @author Naguissa
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+
+#include "uRTCLib.h"
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+/**************************************************************************/
+// utility code, some of this could be exposed in the DateTime API if needed
+/**************************************************************************/
+
+/**
+  Number of days in each month, from January to November. December is not
+  needed. Omitting it avoids an incompatibility with Paul Stoffregen's Time
+  library. C.f. https://github.com/adafruit/RTClib/issues/114
+*/
+const uint8_t daysInMonth[] PROGMEM = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+/**************************************************************************/
+/*!
+    @brief  DateTime constructor from unixtime
+    @param t Initial time in seconds since Jan 1, 1970 (Unix time)
+*/
+/**************************************************************************/
+DateTime::DateTime(uint32_t t)
+{
+	t -= SECONDS_FROM_1970_TO_2000; // bring to 2000 timestamp from 1970
+
+	ss = t % 60;
+	t /= 60;
+	mm = t % 60;
+	t /= 60;
+	hh = t % 24;
+	uint16_t days = t / 24;
+	w = (days + 6) % 7; // Jan 1, 2000 is a Saturday
+	uint8_t leap;
+	for (yOff = 0;; ++yOff)
+	{
+		leap = yOff % 4 == 0;
+		if (days < 365 + leap)
+			break;
+		days -= 365 + leap;
+	}
+	for (m = 1; m < 12; ++m)
+	{
+		uint8_t daysPerMonth = pgm_read_byte(daysInMonth + m - 1);
+		if (leap && m == 2)
+			++daysPerMonth;
+		if (days < daysPerMonth)
+			break;
+		days -= daysPerMonth;
+	}
+	d = days + 1;
+}
+
+// 4-lane kernels. -mavx2 builds use them too, as AVX2 implies SSE4.1; there is no 8-lane AVX2 version.
+#if defined(__SSE4_1__)
+/**
+ * \brief x / d for 4 lanes at once, using a multiply-and-shift magic number
+ *
+ * M and k are only valid for the input range they were computed for, see callers.
+ */
+static inline __m128i div4(__m128i x, uint32_t M, int k)
+{
+	return _mm_srli_epi32(_mm_mullo_epi32(x, _mm_set1_epi32(M)), k);
+}
+
+/**
+ * \brief SSE4.1 kernel of DateTime::toCivil(), 4 unixtimes at once
+ *
+ * Same arithmetic as the scalar path. Every division is replaced by a magic number valid for the whole uint32_t input range.
+ *
+ * @param src 4 unixtimes
+ * @param fields Output: year offset, month, day, hour, minute, second and days since 2000 of each lane
+ */
+static void unixToCivil4(const uint32_t *src, uint32_t fields[7][4])
+{
+	__m128i t = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)src), _mm_set1_epi32(SECONDS_FROM_1970_TO_2000));
+
+	// t / 86400 == (t >> 7) / 675, needs a 64 bit product: even and odd lanes are done apart
+	__m128i x = _mm_srli_epi32(t, 7);
+	__m128i M = _mm_set1_epi32(3257812231u);
+	__m128i even = _mm_srli_epi64(_mm_mul_epu32(x, M), 41);
+	__m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), M), 41);
+	__m128i days = _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+
+	__m128i sod = _mm_sub_epi32(t, _mm_mullo_epi32(days, _mm_set1_epi32(86400)));
+	__m128i hh = div4(_mm_srli_epi32(sod, 4), 4661, 20); // / 3600
+	__m128i rem = _mm_sub_epi32(sod, _mm_mullo_epi32(hh, _mm_set1_epi32(3600)));
+	__m128i mm = div4(_mm_srli_epi32(rem, 2), 1093, 14); // / 60
+	__m128i ss = _mm_sub_epi32(rem, _mm_mullo_epi32(mm, _mm_set1_epi32(60)));
+
+	__m128i z = _mm_add_epi32(days, _mm_set1_epi32(1401));
+	__m128i cycles = div4(z, 22967, 25); // / 1461
+	__m128i doe = _mm_sub_epi32(z, _mm_mullo_epi32(cycles, _mm_set1_epi32(1461)));
+	__m128i yoe = div4(_mm_sub_epi32(doe, div4(doe, 1437, 21)), 1437, 19); // / 1460, / 365
+	__m128i doy = _mm_sub_epi32(doe, _mm_mullo_epi32(yoe, _mm_set1_epi32(365)));
+	__m128i mp = div4(_mm_add_epi32(_mm_mullo_epi32(doy, _mm_set1_epi32(5)), _mm_set1_epi32(2)), 857, 17); // / 153
+	__m128i d = _mm_sub_epi32(doy, div4(_mm_add_epi32(_mm_mullo_epi32(mp, _mm_set1_epi32(153)), _mm_set1_epi32(2)), 1639, 13)); // / 5
+	d = _mm_add_epi32(d, _mm_set1_epi32(1));
+	__m128i m = _mm_add_epi32(mp, _mm_add_epi32(_mm_set1_epi32(3), _mm_and_si128(_mm_cmpgt_epi32(mp, _mm_set1_epi32(9)), _mm_set1_epi32(-12))));
+	__m128i y = _mm_add_epi32(_mm_slli_epi32(cycles, 2), _mm_sub_epi32(yoe, _mm_set1_epi32(4)));
+	y = _mm_sub_epi32(y, _mm_cmpgt_epi32(_mm_set1_epi32(3), m)); // true is -1
+
+	_mm_storeu_si128((__m128i *)fields[0], y);
+	_mm_storeu_si128((__m128i *)fields[1], m);
+	_mm_storeu_si128((__m128i *)fields[2], d);
+	_mm_storeu_si128((__m128i *)fields[3], hh);
+	_mm_storeu_si128((__m128i *)fields[4], mm);
+	_mm_storeu_si128((__m128i *)fields[5], ss);
+	_mm_storeu_si128((__m128i *)fields[6], days);
+}
+
+/**
+ * \brief SSE4.1 kernel of DateTime::toUnix(), 4 DateTimes at once
+ *
+ * Same arithmetic as DateTime::unixtime(), including its 16 bit day count.
+ *
+ * @param fields Year offset, month, day, hour, minute and second of each lane
+ * @param dst Output: 4 unixtimes
+ */
+static void civilToUnix4(const uint32_t fields[6][4], uint32_t *dst)
+{
+	__m128i y = _mm_loadu_si128((const __m128i *)fields[0]);
+	__m128i m = _mm_loadu_si128((const __m128i *)fields[1]);
+
+	__m128i afterFeb = _mm_cmpgt_epi32(m, _mm_set1_epi32(2));
+	__m128i leap = _mm_and_si128(_mm_cmpeq_epi32(_mm_and_si128(y, _mm_set1_epi32(3)), _mm_setzero_si128()), _mm_set1_epi32(1));
+	__m128i fromMarch = div4(_mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(m, _mm_set1_epi32(3)), _mm_set1_epi32(153)), _mm_set1_epi32(2)), 1639, 13); // / 5
+	fromMarch = _mm_add_epi32(fromMarch, _mm_add_epi32(_mm_set1_epi32(59), leap));
+	__m128i beforeMarch = _mm_mullo_epi32(_mm_sub_epi32(m, _mm_set1_epi32(1)), _mm_set1_epi32(31));
+	__m128i days = _mm_blendv_epi8(beforeMarch, fromMarch, afterFeb);
+
+	days = _mm_add_epi32(days, _mm_loadu_si128((const __m128i *)fields[2]));
+	days = _mm_add_epi32(days, _mm_mullo_epi32(y, _mm_set1_epi32(365)));
+	days = _mm_add_epi32(days, _mm_srli_epi32(_mm_add_epi32(y, _mm_set1_epi32(3)), 2));
+	days = _mm_and_si128(_mm_sub_epi32(days, _mm_set1_epi32(1)), _mm_set1_epi32(0xFFFF));
+
+	__m128i t = _mm_add_epi32(_mm_mullo_epi32(days, _mm_set1_epi32(24)), _mm_loadu_si128((const __m128i *)fields[3]));
+	t = _mm_add_epi32(_mm_mullo_epi32(t, _mm_set1_epi32(60)), _mm_loadu_si128((const __m128i *)fields[4]));
+	t = _mm_add_epi32(_mm_mullo_epi32(t, _mm_set1_epi32(60)), _mm_loadu_si128((const __m128i *)fields[5]));
+	_mm_storeu_si128((__m128i *)dst, _mm_add_epi32(t, _mm_set1_epi32(SECONDS_FROM_1970_TO_2000)));
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Convert an array of unixtimes to DateTime objects
+            Results are identical to DateTime(uint32_t) on each element, but years and months are
+            computed in closed form instead of loops, 4 elements at a time when SSE4.1 is available.
+    @param src Unixtimes, seconds since Jan 1, 1970
+    @param dst Destination DateTime array, at least n elements
+    @param n Number of elements
+*/
+/**************************************************************************/
+void DateTime::toCivil(const uint32_t *src, DateTime *dst, size_t n)
+{
+	size_t i = 0;
+#if defined(__SSE4_1__)
+	uint32_t fields[7][4];
+	for (; i + 4 <= n; i += 4)
+	{
+		unixToCivil4(src + i, fields);
+		for (uint8_t j = 0; j < 4; ++j)
+		{
+			dst[i + j].yOff = fields[0][j];
+			dst[i + j].m = fields[1][j];
+			dst[i + j].d = fields[2][j];
+			dst[i + j].hh = fields[3][j];
+			dst[i + j].mm = fields[4][j];
+			dst[i + j].ss = fields[5][j];
+			dst[i + j].w = (fields[6][j] + 6) % 7;
+		}
+	}
+#endif
+	for (; i < n; ++i)
+	{
+		uint32_t t = src[i] - SECONDS_FROM_1970_TO_2000; // bring to 2000 timestamp from 1970
+		uint32_t days = t / 86400;
+		uint32_t sod = t - days * 86400;
+		dst[i].w = (days + 6) % 7;
+		dst[i].hh = sod / 3600;
+		sod -= dst[i].hh * 3600UL;
+		dst[i].mm = sod / 60;
+		dst[i].ss = sod - dst[i].mm * 60;
+
+		// Count from 1996-03-01, so leap day is the last day of every 4-year cycle
+		uint16_t z = days + 1401;
+		uint16_t cycles = z / 1461;
+		uint16_t doe = z - cycles * 1461;
+		uint16_t yoe = (doe - doe / 1460) / 365;
+		uint16_t doy = doe - yoe * 365;
+		uint8_t mp = (5 * doy + 2) / 153; // Month, starting at March = 0
+		dst[i].d = doy - (153 * mp + 2) / 5 + 1;
+		dst[i].m = mp < 10 ? mp + 3 : mp - 9;
+		dst[i].yOff = 4 * cycles + yoe + (dst[i].m <= 2) - 4;
+	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert an array of DateTime objects to unixtimes
+            Results are identical to unixtime() on each element, 4 elements at a time when SSE4.1 is available.
+    @param src DateTime array
+    @param dst Destination unixtime array, at least n elements
+    @param n Number of elements
+*/
+/**************************************************************************/
+void DateTime::toUnix(const DateTime *src, uint32_t *dst, size_t n)
+{
+	size_t i = 0;
+#if defined(__SSE4_1__)
+	uint32_t fields[6][4];
+	for (; i + 4 <= n; i += 4)
+	{
+		for (uint8_t j = 0; j < 4; ++j)
+		{
+			fields[0][j] = src[i + j].yOff;
+			fields[1][j] = src[i + j].m;
+			fields[2][j] = src[i + j].d;
+			fields[3][j] = src[i + j].hh;
+			fields[4][j] = src[i + j].mm;
+			fields[5][j] = src[i + j].ss;
+		}
+		civilToUnix4(fields, dst + i);
+	}
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i].unixtime();
+}
+
+/**************************************************************************/
+/*!
+    @brief  A convenient constructor for using "the compiler's time":
+            This version will save RAM by using PROGMEM to store it by using the F macro.
+            DateTime now (F(__DATE__), F(__TIME__));
+    @param date Date string, e.g. "Dec 26 2009"
+    @param time Time string, e.g. "12:34:56"
+*/
+/**************************************************************************/
+DateTime::DateTime(const __FlashStringHelper *date, const __FlashStringHelper *time)
+{
+	// sample input: date = "Dec 26 2009", time = "12:34:56"
+	char buff[11];
+	memcpy_P(buff, date, 11);
+	yOff = conv2d(buff + 9);
+	m = conv2month(buff);
+	d = conv2d(buff + 4);
+	memcpy_P(buff, time, 8);
+	hh = conv2d(buff);
+	mm = conv2d(buff + 3);
+	ss = conv2d(buff + 6);
+	w = (date2days(yOff, m, d) + 6) % 7;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Return DateTime in based on user defined format.
+    @param buffer: array of char for holding the format description and the formatted DateTime. 
+                   Before calling this method, the buffer should be initialized by the user with 
+                   a format string, e.g. "YYYY-MM-DD hh:mm:ss". The method will overwrite 
+                   the buffer with the formatted date and/or time.
+    @return a pointer to the provided buffer. This is returned for convenience, 
+            in order to enable idioms such as Serial.println(now.toString(buffer));
+*/
+/**************************************************************************/
+
+char *DateTime::toString(char *buffer)
+{
+	size_t length = strlen(buffer);
+	for (size_t i = 0; i + 1 < length; i++) // not i < length - 1, which wraps around on an empty buffer
+	{
+		if (buffer[i] == 'h' && buffer[i + 1] == 'h')
+		{
+			buffer[i] = '0' + hh / 10;
+			buffer[i + 1] = '0' + hh % 10;
+		}
+		if (buffer[i] == 'm' && buffer[i + 1] == 'm')
+		{
+			buffer[i] = '0' + mm / 10;
+			buffer[i + 1] = '0' + mm % 10;
+		}
+		if (buffer[i] == 's' && buffer[i + 1] == 's')
+		{
+			buffer[i] = '0' + ss / 10;
+			buffer[i + 1] = '0' + ss % 10;
+		}
+		if (buffer[i] == 'D' && buffer[i + 1] == 'D' && buffer[i + 2] == 'D')
+		{
+			static PROGMEM const char day_names[] = "SunMonTueWedThuFriSat";
+			const char *p = &day_names[3 * dayOfTheWeek()];
+			buffer[i] = pgm_read_byte(p);
+			buffer[i + 1] = pgm_read_byte(p + 1);
+			buffer[i + 2] = pgm_read_byte(p + 2);
+		}
+		else if (buffer[i] == 'D' && buffer[i + 1] == 'D')
+		{
+			buffer[i] = '0' + d / 10;
+			buffer[i + 1] = '0' + d % 10;
+		}
+		if (buffer[i] == 'M' && buffer[i + 1] == 'M' && buffer[i + 2] == 'M')
+		{
+			static PROGMEM const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+			const char *p = &month_names[3 * (m - 1)];
+			buffer[i] = pgm_read_byte(p);
+			buffer[i + 1] = pgm_read_byte(p + 1);
+			buffer[i + 2] = pgm_read_byte(p + 2);
+		}
+		else if (buffer[i] == 'M' && buffer[i + 1] == 'M')
+		{
+			buffer[i] = '0' + m / 10;
+			buffer[i + 1] = '0' + m % 10;
+		}
+		if (buffer[i] == 'Y' && buffer[i + 1] == 'Y' && buffer[i + 2] == 'Y' && buffer[i + 3] == 'Y')
+		{
+			buffer[i] = '2';
+			buffer[i + 1] = '0' + yOff / 100; // 2000 to 2255
+			buffer[i + 2] = '0' + (yOff / 10) % 10;
+			buffer[i + 3] = '0' + yOff % 10;
+		}
+		else if (buffer[i] == 'Y' && buffer[i + 1] == 'Y')
+		{
+			buffer[i] = '0' + (yOff / 10) % 10;
+			buffer[i + 1] = '0' + yOff % 10;
+		}
+	}
+	return buffer;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add a TimeSpan to the DateTime object
+    @param span TimeSpan object
+    @return new DateTime object with span added to it
+*/
+/**************************************************************************/
+DateTime DateTime::operator+(const TimeSpan &span)
+{
+	DateTime result(*this);
+	return result.addSeconds(span.totalseconds());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Subtract a TimeSpan from the DateTime object
+    @param span TimeSpan object
+    @return new DateTime object with span subtracted from it
+*/
+/**************************************************************************/
+DateTime DateTime::operator-(const TimeSpan &span)
+{
+	DateTime result(*this);
+	return result.addSeconds(-span.totalseconds());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add a TimeSpan to this DateTime, in place
+    @param span TimeSpan object
+    @return this DateTime, with span added
+*/
+/**************************************************************************/
+DateTime &DateTime::operator+=(const TimeSpan &span)
+{
+	return addSeconds(span.totalseconds());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Subtract a TimeSpan from this DateTime, in place
+    @param span TimeSpan object
+    @return this DateTime, with span subtracted
+*/
+/**************************************************************************/
+DateTime &DateTime::operator-=(const TimeSpan &span)
+{
+	return addSeconds(-span.totalseconds());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of days in a month
+    @param yOff Year offset from 2000
+    @param m Month 1-12
+    @return Days in month, 28 to 31
+*/
+/**************************************************************************/
+static uint8_t daysOfMonth(uint8_t yOff, uint8_t m)
+{
+	if (m == 12)
+		return 31;
+	return pgm_read_byte(daysInMonth + m - 1) + (m == 2 && yOff % 4 == 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add seconds in place, carrying field by field
+            Steps under a day only touch the time fields, plus at most one
+            day carry; longer ones fall back to a full unixtime conversion.
+    @param seconds Seconds to add, may be negative
+    @return this DateTime
+*/
+/**************************************************************************/
+DateTime &DateTime::addSeconds(int32_t seconds)
+{
+	if (seconds >= 0 && seconds < 60)
+	{
+		// Most common case, sampling steps: no division at all
+		ss += seconds;
+		if (ss < 60)
+			return *this;
+		ss -= 60;
+		if (++mm < 60)
+			return *this;
+		mm = 0;
+		if (++hh < 24)
+			return *this;
+		hh = 0;
+		return addDays(1);
+	}
+	if (seconds <= -SECONDS_PER_DAY || seconds >= SECONDS_PER_DAY)
+	{
+		*this = DateTime(unixtime() + seconds);
+		return *this;
+	}
+
+	int32_t t = (hh * 60 + mm) * 60L + ss + seconds; // seconds of day, -86399 to 2 * 86399
+	int8_t days = 0;
+	if (t < 0)
+	{
+		t += SECONDS_PER_DAY;
+		days = -1;
+	}
+	else if (t >= SECONDS_PER_DAY)
+	{
+		t -= SECONDS_PER_DAY;
+		days = 1;
+	}
+	uint16_t minutes = t / 60;
+	ss = t - minutes * 60L;
+	hh = minutes / 60;
+	mm = minutes - hh * 60;
+	return days ? addDays(days) : *this;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add days in place, keeping the time of day
+            Steps inside the month only touch the day; up to a month away
+            month and year are carried, longer ones use full conversion.
+    @param days Days to add, may be negative
+    @return this DateTime
+*/
+/**************************************************************************/
+DateTime &DateTime::addDays(int16_t days)
+{
+	if (days < -31 || days > 31)
+	{
+		*this = DateTime(unixtime() + (uint32_t)(int32_t)days * (uint32_t)SECONDS_PER_DAY); // modulo 2^32, no signed overflow on 32-bit long
+		return *this;
+	}
+
+	w = (w + days % 7 + 7) % 7;
+	int8_t day = d + days;
+	while (day > daysOfMonth(yOff, m))
+	{
+		day -= daysOfMonth(yOff, m);
+		if (++m > 12)
+		{
+			m = 1;
+			yOff++;
+		}
+	}
+	while (day < 1)
+	{
+		if (--m < 1)
+		{
+			m = 12;
+			yOff--;
+		}
+		day += daysOfMonth(yOff, m);
+	}
+	d = day;
+	return *this;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add months in place, keeping day and time of day
+            Day is clamped to the last day of the resulting month, i.e. Jan 31 + 1 month is Feb 28 or 29.
+            Months before 2000-01 are not representable, the result is clamped to 2000-01.
+    @param months Months to add, may be negative
+    @return this DateTime
+*/
+/**************************************************************************/
+DateTime &DateTime::addMonths(int16_t months)
+{
+	int16_t total = yOff * 12 + m - 1 + months;
+	if (total < 0)
+		total = 0;
+	yOff = total / 12;
+	m = total % 12 + 1;
+	uint8_t last = daysOfMonth(yOff, m);
+	if (d > last)
+		d = last;
+	w = (date2days(yOff, m, d) + 6) % 7;
+	return *this;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Subtract one DateTime from another
+    @param right The DateTime object to subtract from self (the left object)
+    @return TimeSpan of the difference between DateTimes
+*/
+/**************************************************************************/
+TimeSpan DateTime::operator-(const DateTime &right)
+{
+	return TimeSpan(unixtime() - right.unixtime());
+}
+
+/**************************************************************************/
+/*!
+    @brief  ISO 8601 Timestamp
+    @param opt Format of the timestamp
+    @return Timestamp string, e.g. "2000-01-01T12:34:56"
+*/
+/**************************************************************************/
+String DateTime::timestamp(timestampOpt opt)
+{
+	char buffer[25]; // "YYYY-MM-DDThh:mm:ss" needs 20, but 3 digits per uint8_t field keep -Wformat-overflow quiet
+
+	//Generate timestamp according to opt
+	switch (opt)
+	{
+	case TIMESTAMP_TIME:
+		//Only time
+		snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", hh, mm, ss);
+		break;
+	case TIMESTAMP_DATE:
+		//Only date
+		snprintf(buffer, sizeof(buffer), "%d-%02d-%02d", 2000 + yOff, m, d);
+		break;
+	default:
+		//Full
+		snprintf(buffer, sizeof(buffer), "%d-%02d-%02dT%02d:%02d:%02d", 2000 + yOff, m, d, hh, mm, ss);
+	}
+	return String(buffer);
+}
+
+/**************************************************************************/
+/*!
+    @brief  DateTimeRange constructor
+    @param from Start, its unit is the first element
+    @param to End, its unit is the last element; may be before from to walk backwards
+    @param unit Step unit, see rangeUnit
+*/
+/**************************************************************************/
+DateTimeRange::DateTimeRange(const DateTime &from, const DateTime &to, rangeUnit unit)
+		: _first(unitStart(from, unit)), _last(unitStart(to, unit)), _unit(unit), _step(to < from ? -1 : 1)
+{
+}
+
+/**************************************************************************/
+/*!
+    @brief  First day of the day, ISO week or month containing a DateTime, at 00:00:00
+            The week containing 2000-01-01 starts on 1999-12-27, which is not representable: it starts on 2000-01-01.
+    @param dt DateTime
+    @param unit Unit, see rangeUnit
+    @return Start of unit
+*/
+/**************************************************************************/
+DateTime DateTimeRange::unitStart(const DateTime &dt, rangeUnit unit)
+{
+	if (unit == RANGE_MONTHS)
+		return DateTime(dt.year(), dt.month(), 1);
+
+	DateTime start(dt.year(), dt.month(), dt.day(), 0, 0, 0, dt.dayOfTheWeek());
+	if (unit == RANGE_WEEKS)
+	{
+		uint8_t back = (dt.dayOfTheWeek() + 6) % 7; // back to Monday
+		if (dt.year() == 2000 && dt.month() == 1 && back >= dt.day())
+			back = dt.day() - 1; // but not before 2000-01-01
+		start.addDays(-back);
+	}
+	return start;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Step to next element, updating fields in place
+            A backward walk ends at 2000-01-01, the first representable day, whatever the last element is.
+    @return this iterator
+*/
+/**************************************************************************/
+DateTimeRange::iterator &DateTimeRange::iterator::operator++()
+{
+	bool floor = _current.year() == 2000 && _current.month() == 1;
+	if (_step < 0 && floor && _current.day() == 1)
+	{
+		_step = 0; // nothing before 2000-01-01
+		return *this;
+	}
+
+	if (_unit == RANGE_MONTHS)
+		_current.addMonths(_step);
+	else if (_unit == RANGE_DAYS)
+		_current.addDays(_step);
+	else if (_step > 0)
+		_current.addDays(7 - (_current.dayOfTheWeek() + 6) % 7); // next Monday, also from a week clamped to 2000-01-01
+	else if (floor && _current.day() <= 7)
+		_current.addDays(1 - _current.day()); // week starting before 2000-01-01
+	else
+		_current.addDays(-7);
+	return *this;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Saturating 64-bit addition
+    @param a First operand
+    @param b Second operand
+    @return a + b, or URTCLIB_MS_MIN / URTCLIB_MS_MAX on overflow
+*/
+/**************************************************************************/
+static int64_t saturatingAdd(int64_t a, int64_t b)
+{
+	int64_t result;
+	if (__builtin_add_overflow(a, b, &result))
+		return b < 0 ? URTCLIB_MS_MIN : URTCLIB_MS_MAX;
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Saturating 64-bit subtraction
+    @param a First operand
+    @param b Second operand
+    @return a - b, or URTCLIB_MS_MIN / URTCLIB_MS_MAX on overflow
+*/
+/**************************************************************************/
+static int64_t saturatingSub(int64_t a, int64_t b)
+{
+	int64_t result;
+	if (__builtin_sub_overflow(a, b, &result))
+		return b > 0 ? URTCLIB_MS_MIN : URTCLIB_MS_MAX;
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert to TimeSpan, truncating milliseconds towards zero
+    @return TimeSpan, saturated to its range
+*/
+/**************************************************************************/
+TimeSpan Duration::toTimeSpan() const
+{
+	int64_t seconds = _ms / 1000;
+	if (seconds > 0x7FFFFFFFL)
+		return TimeSpan(0x7FFFFFFFL);
+	if (seconds < -0x7FFFFFFFL - 1)
+		return TimeSpan(-0x7FFFFFFFL - 1);
+	return TimeSpan((int32_t)seconds);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Split into days, hours, minutes, seconds and milliseconds in one pass.
+            There is one wide division, by a day; each field then comes from the remainder of the previous
+            one in 32 and 16 bits, so AVR does not run 64-bit divisions per field as TimeSpan accessors do.
+            Durations under ~49 days do not use 64-bit division at all.
+    @return Parts, with the magnitude of the Duration and its sign
+*/
+/**************************************************************************/
+Duration::Parts Duration::split() const
+{
+	Parts parts;
+	parts.negative = _ms < 0;
+	uint64_t magnitude = parts.negative ? 0 - (uint64_t)_ms : (uint64_t)_ms;
+
+	uint32_t rest; // milliseconds within the day
+	if (magnitude >> 32)
+	{
+		uint64_t days = magnitude / 86400000UL;
+		rest = magnitude - days * 86400000UL;
+		parts.days = days > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : days;
+	}
+	else
+	{
+		parts.days = (uint32_t)magnitude / 86400000UL;
+		rest = (uint32_t)magnitude - parts.days * 86400000UL;
+	}
+	uint32_t seconds = rest / 1000;
+	parts.milliseconds = rest - seconds * 1000;
+	parts.hours = seconds / 3600;
+	uint16_t inHour = seconds - parts.hours * 3600UL;
+	parts.minutes = inHour / 60;
+	parts.seconds = inHour - parts.minutes * 60;
+	return parts;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add two Durations, saturating
+    @param right Duration to add
+    @return Sum
+*/
+/**************************************************************************/
+Duration Duration::operator+(const Duration &right) const { return Duration(saturatingAdd(_ms, right._ms)); }
+
+/**************************************************************************/
+/*!
+    @brief  Subtract a Duration, saturating
+    @param right Duration to subtract
+    @return Difference
+*/
+/**************************************************************************/
+Duration Duration::operator-(const Duration &right) const { return Duration(saturatingSub(_ms, right._ms)); }
+
+/**************************************************************************/
+/*!
+    @brief  Negate, saturating: URTCLIB_MS_MIN becomes URTCLIB_MS_MAX
+    @return Negated Duration
+*/
+/**************************************************************************/
+Duration Duration::operator-() const { return Duration(saturatingSub(0, _ms)); }
+
+/**************************************************************************/
+/*!
+    @brief  Convert to DateTime, dropping milliseconds
+    @return DateTime of the Instant second; only valid from 2000 to 2106
+*/
+/**************************************************************************/
+DateTime Instant::toDateTime() const
+{
+	int64_t seconds = _ms / 1000;
+	return DateTime((uint32_t)(_ms % 1000 < 0 ? seconds - 1 : seconds));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Millisecond within the second
+    @return Millisecond 0-999
+*/
+/**************************************************************************/
+uint16_t Instant::millisecond() const
+{
+	int16_t ms = _ms % 1000;
+	return ms < 0 ? ms + 1000 : ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add a Duration, saturating
+    @param span Duration to add
+    @return Later (or earlier, for negative spans) Instant
+*/
+/**************************************************************************/
+Instant Instant::operator+(const Duration &span) const { return Instant(saturatingAdd(_ms, span.totalMilliseconds())); }
+
+/**************************************************************************/
+/*!
+    @brief  Subtract a Duration, saturating
+    @param span Duration to subtract
+    @return Earlier (or later, for negative spans) Instant
+*/
+/**************************************************************************/
+Instant Instant::operator-(const Duration &span) const { return Instant(saturatingSub(_ms, span.totalMilliseconds())); }
+
+/**************************************************************************/
+/*!
+    @brief  Time between two Instants, saturating
+    @param right Instant to subtract
+    @return Duration from right to left
+*/
+/**************************************************************************/
+Duration Instant::operator-(const Instant &right) const { return Duration(saturatingSub(_ms, right._ms)); }
+
+/************** BCD ****************/
+
+/**
+ * \brief Decodes the 7-byte time register block (00h to 06h) in place
+ *
+ * Control bits are masked out before decoding: CH on seconds, 12/24 and AM/PM on hours and Century on month.
+ * Hours are always returned in 24h format and Century bit is added to year, so buffer[6] becomes year offset from 2000.
+ *
+ * @param buffer Raw registers as read from RTC: second, minute, hour, dow, day, month, year
+ */
+void uRTCLibBcd::decodeTimeBlock(uint8_t *buffer)
+{
+	uint8_t hourReg = buffer[2];
+	bool century = buffer[5] & 0b10000000;
+	uint32_t low = (uint32_t) (buffer[0] & 0b01111111)
+		| ((uint32_t) (buffer[1] & 0b01111111) << 8)
+		| ((uint32_t) (hourReg & ((hourReg & 0b01000000) ? 0b00011111 : 0b00111111)) << 16)
+		| ((uint32_t) (buffer[3] & 0b00000111) << 24);
+	uint32_t high = (uint32_t) (buffer[4] & 0b00111111)
+		| ((uint32_t) (buffer[5] & 0b00011111) << 8)
+		| ((uint32_t) buffer[6] << 16);
+
+	low = bcd2bin4(low);
+	high = bcd2bin4(high);
+
+	buffer[0] = low;
+	buffer[1] = low >> 8;
+	buffer[2] = low >> 16;
+	buffer[3] = low >> 24;
+	buffer[4] = high;
+	buffer[5] = high >> 8;
+	buffer[6] = high >> 16;
+
+	if (hourReg & 0b01000000) // 12h mode: 12AM is 0h, PM adds 12h
+	{
+		buffer[2] %= 12;
+		if (hourReg & 0b00100000)
+			buffer[2] += 12;
+	}
+	if (century)
+		buffer[6] += 100;
+}
+
+/************** Timestamp streams ****************/
+
+/**
+ * \brief Writes a token: LEB128 varint of value * 2 + tag, in 32-bit arithmetic
+ *
+ * First byte holds the tag and 6 value bits, next ones 7 bits each.
+ *
+ * @param out Destination, up to 5 bytes
+ * @param value Token value
+ * @param tag Token tag, 0 or 1
+ *
+ * @return Bytes written
+ */
+static uint8_t stampTokenWrite(uint8_t *out, uint32_t value, const uint8_t tag)
+{
+	uint8_t n = 0;
+	uint8_t byte = tag | (value & 0x3F) << 1;
+
+	for (value >>= 6; value; value >>= 7)
+	{
+		out[n++] = byte | 0x80;
+		byte = value & 0x7F;
+	}
+	out[n++] = byte;
+	return n;
+}
+
+/**
+ * \brief Reads a token written by stampTokenWrite()
+ *
+ * @param p Current position
+ * @param end End of data
+ * @param value Token value
+ * @param tag Token tag
+ *
+ * @return Position after the token; 0 at end of data or on a truncated token
+ */
+static inline const uint8_t *stampTokenRead(const uint8_t *p, const uint8_t *end, uint32_t &value, uint8_t &tag)
+{
+	if (p == end)
+		return 0;
+	uint8_t byte = *p++;
+	tag = byte & 1;
+	value = (byte >> 1) & 0x3F;
+	for (uint8_t shift = 6; byte & 0x80; shift += 7)
+	{
+		if (p == end || shift > 27)
+			return 0;
+		byte = *p++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+	}
+	return p;
+}
+
+/**
+ * \brief Adds a stamp to the stream
+ *
+ * @param unixtime Stamp
+ * @param out Destination, #URTCLIB_STAMP_MAX_BYTES bytes free
+ *
+ * @return Bytes written; 0 if the stamp extends a run
+ */
+uint8_t uRTCLibStampEncoder::encode(const uint32_t unixtime, uint8_t *out)
+{
+	if (!_started)
+	{
+		_started = true;
+		_last = unixtime;
+		_delta = 0;
+		return stampTokenWrite(out, unixtime, 0);
+	}
+
+	uint32_t delta = unixtime - _last;
+	uint32_t dod = delta - _delta;
+	_last = unixtime;
+	_delta = delta;
+	if (dod == 0)
+	{
+		return ++_run == 0xFFFF ? flush(out) : 0;
+	}
+	uint8_t n = flush(out);
+	return n + stampTokenWrite(out + n, (dod << 1) ^ (uint32_t)((int32_t)dod >> 31), 0); // zigzag: small magnitudes, small values
+}
+
+/**
+ * \brief Writes the pending run, if any
+ *
+ * @param out Destination, #URTCLIB_STAMP_MAX_BYTES bytes free
+ *
+ * @return Bytes written
+ */
+uint8_t uRTCLibStampEncoder::flush(uint8_t *out)
+{
+	if (!_run)
+		return 0;
+	uint8_t n = stampTokenWrite(out, _run, 1);
+	_run = 0;
+	return n;
+}
+
+/**
+ * \brief Constructor
+ *
+ * @param data Encoded stream
+ * @param length Stream length, bytes
+ */
+uRTCLibStampDecoder::uRTCLibStampDecoder(const uint8_t *data, const size_t length) : _data(data), _end(data + length) {}
+
+/**
+ * \brief Decodes next stamp
+ *
+ * @param unixtime Decoded stamp
+ *
+ * @return false at end of stream, or on a corrupt or truncated one
+ */
+bool uRTCLibStampDecoder::next(uint32_t &unixtime)
+{
+	if (!_run)
+	{
+		uint32_t value;
+		uint8_t tag;
+		const uint8_t *p = stampTokenRead(_data, _end, value, tag);
+		if (!p || (tag && (!_started || !value || value > 0xFFFF)))
+			return false;
+		_data = p;
+		if (!_started)
+		{
+			_started = true;
+			_last = unixtime = value;
+			return true;
+		}
+		if (!tag)
+		{
+			_delta += (value >> 1) ^ (0 - (value & 1));
+			_last += _delta;
+			unixtime = _last;
+			return true;
+		}
+		_run = value;
+	}
+	_run--;
+	_last += _delta;
+	unixtime = _last;
+	return true;
+}
+
+/**
+ * \brief Decodes a whole stream
+ *
+ * @param data Encoded stream
+ * @param length Stream length, bytes
+ * @param out Decoded stamps
+ * @param max out size, stamps
+ *
+ * @return Decoded stamps; decoding stops at max, or on a corrupt or truncated token
+ */
+size_t uRTCLibStampDecoder::decode(const uint8_t *data, const size_t length, uint32_t *out, const size_t max)
+{
+	const uint8_t *end = data + length;
+	uint32_t value, last, delta = 0;
+	uint8_t tag;
+	size_t n = 0;
+
+	if (!max || !(data = stampTokenRead(data, end, value, tag)) || tag)
+		return 0;
+	out[n++] = last = value;
+	while (n < max && (data = stampTokenRead(data, end, value, tag)))
+	{
+		if (!tag)
+		{
+			delta += (value >> 1) ^ (0 - (value & 1));
+			out[n++] = last += delta;
+			continue;
+		}
+		if (!value || value > 0xFFFF)
+			break;
+		size_t stop = max - n < value ? max : n + value;
+		for (; n < stop; n++)
+		{
+			out[n] = last += delta;
+		}
+	}
+	return n;
+}
+
+/************** Cron ****************/
+
+/**
+ * \brief Parses an unsigned number
+ *
+ * @param p Text
+ * @param value Output
+ *
+ * @return Pointer after the number, NULL if there is no number or it is over 255
+ */
+static const char *cronNumber(const char *p, uint8_t &value)
+{
+	uint16_t n = 0;
+	if (*p < '0' || *p > '9')
+		return NULL;
+	while (*p >= '0' && *p <= '9')
+	{
+		n = n * 10 + *p++ - '0';
+		if (n > 255)
+			return NULL;
+	}
+	value = n;
+	return p;
+}
+
+/**
+ * \brief Parses a cron field into a bitset
+ *
+ * @param p Field text
+ * @param min Lowest valid value
+ * @param max Highest valid value
+ * @param bits Output, bit n set if n matches
+ * @param any Output, true if field starts with *
+ *
+ * @return Pointer to next field, NULL on syntax or range error
+ */
+static const char *cronField(const char *p, const uint8_t min, const uint8_t max, uint64_t &bits, bool &any)
+{
+	while (*p == ' ')
+		p++;
+	bits = 0;
+	any = *p == '*';
+	do
+	{
+		uint8_t from = min, to = max, step = 1;
+		if (*p == '*')
+		{
+			p++;
+		}
+		else
+		{
+			if (!(p = cronNumber(p, from)))
+				return NULL;
+			to = from;
+			if (*p == '-' && !(p = cronNumber(p + 1, to)))
+				return NULL;
+			else if (*p == '/')
+				to = max; // a/s, from a to the end
+		}
+		if (*p == '/' && (!(p = cronNumber(p + 1, step)) || step == 0))
+			return NULL;
+		if (from < min || to > max || from > to)
+			return NULL;
+		for (uint16_t v = from; v <= to; v += step)
+			bits |= (uint64_t)1 << v;
+	} while (*p == ',' && *++p);
+	return *p == ' ' || *p == 0 ? p : NULL;
+}
+
+/**
+ * \brief Constructor, empty schedule that never matches
+ */
+uRTCLibCron::uRTCLibCron() : _minutes(0), _hours(0), _days(0), _months(0), _weekdays(0), _anyDay(false), _anyWeekday(false) {}
+
+/**
+ * \brief Constructor
+ *
+ * @param expression Cron expression, see parse(); schedule is left empty if not valid
+ */
+uRTCLibCron::uRTCLibCron(const char *expression) : uRTCLibCron()
+{
+	parse(expression);
+}
+
+/**
+ * \brief Compiles a cron expression
+ *
+ * @param expression "minute hour day-of-month month day-of-week"
+ *
+ * @return true if valid. If not, schedule is left empty and never matches
+ */
+bool uRTCLibCron::parse(const char *expression)
+{
+	uint64_t minutes, hours, days, months, weekdays;
+	bool any;
+	const char *p = expression;
+
+	if (!(p = cronField(p, 0, 59, minutes, any)) || !(p = cronField(p, 0, 23, hours, any)) ||
+			!(p = cronField(p, 1, 31, days, _anyDay)) || !(p = cronField(p, 1, 12, months, any)) ||
+			!(p = cronField(p, 0, 7, weekdays, _anyWeekday)))
+	{
+		*this = uRTCLibCron();
+		return false;
+	}
+	while (*p == ' ')
+		p++;
+	if (*p)
+	{
+		*this = uRTCLibCron();
+		return false;
+	}
+
+	_minutes = minutes;
+	_hours = hours;
+	_days = days;
+	_months = months;
+	_weekdays = (weekdays | weekdays >> 7) & 0b01111111; // 7 is Sunday too
+	return true;
+}
+
+/**
+ * \brief Checks day of month and day of week fields
+ *
+ * @param dt Date to check
+ *
+ * @return true if day matches
+ */
+bool uRTCLibCron::dayMatches(const DateTime &dt) const
+{
+	bool day = (_days >> dt.day()) & 1;
+	bool weekday = (_weekdays >> dt.dayOfTheWeek()) & 1;
+	return _anyDay || _anyWeekday ? day && weekday : day || weekday;
+}
+
+/**
+ * \brief Checks if a DateTime matches the schedule, seconds are ignored
+ *
+ * Constant time, one bit test per field.
+ *
+ * @param dt DateTime to check
+ *
+ * @return true on match
+ */
+bool uRTCLibCron::matches(const DateTime &dt) const
+{
+	return ((_minutes >> dt.minute()) & 1) && ((_hours >> dt.hour()) & 1) && ((_months >> dt.month()) & 1) && dayMatches(dt);
+}
+
+/**
+ * \brief Finds next match, strictly after a given time
+ *
+ * Skips whole months, days and hours that do not match, and finds hour and minute in the bitsets directly,
+ * so it takes a few steps per skipped day at most.
+ *
+ * @param after Search start, not included
+ * @param result Output: next match, seconds are 0
+ *
+ * @return false if there is no match in next 8 years (i.e. empty schedule or February 30th)
+ */
+bool uRTCLibCron::next(const DateTime &after, DateTime &result) const
+{
+	DateTime t(after.year(), after.month(), after.day(), after.hour(), after.minute(), 0, after.dayOfTheWeek());
+	t.addSeconds(60);
+
+	while (t.year() <= after.year() + 8)
+	{
+		if (!((_months >> t.month()) & 1))
+		{
+			t = DateTime(t.year(), t.month(), 1);
+			t.addMonths(1);
+			continue;
+		}
+		if (!dayMatches(t))
+		{
+			t = DateTime(t.year(), t.month(), t.day(), 0, 0, 0, t.dayOfTheWeek());
+			t.addDays(1);
+			continue;
+		}
+		uint32_t hours = _hours >> t.hour();
+		if (!hours)
+		{
+			t = DateTime(t.year(), t.month(), t.day(), 0, 0, 0, t.dayOfTheWeek());
+			t.addDays(1);
+			continue;
+		}
+		if (!(hours & 1)) // later hour, from its first minute
+		{
+			t = DateTime(t.year(), t.month(), t.day(), t.hour() + __builtin_ctzl(hours), 0, 0, t.dayOfTheWeek());
+		}
+		uint64_t minutes = _minutes >> t.minute();
+		if (!minutes)
+		{
+			t = DateTime(t.year(), t.month(), t.day(), t.hour(), 0, 0, t.dayOfTheWeek());
+			t.addSeconds(3600);
+			continue;
+		}
+		result = DateTime(t.year(), t.month(), t.day(), t.hour(), t.minute() + __builtin_ctzll(minutes), 0, t.dayOfTheWeek());
+		return true;
+	}
+	return false;
+}
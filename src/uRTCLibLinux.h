@@ -0,0 +1,87 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Linux (i2c-dev) support: the small Arduino subset used by uRTCLib, so it builds without Arduino.h and Wire.h.
+ *
+ * Registers are accessed through /dev/i2c-N with I2C_RDWR ioctl, see uRTCLib::i2cOpen().
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+/** \file uRTCLibLinux.h
+ *   \brief uRTCLib Linux compatibility header file
+ */
+#ifndef URTCLIB_LINUX_H
+/**
+	 * \brief Prevent multiple inclussion
+	 */
+#define URTCLIB_LINUX_H
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef std::string String;
+
+// No separate flash address space, constant tables are plain memory
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+/**
+ * \brief Milliseconds from an arbitrary start, wraps as on Arduino
+ */
+static inline uint32_t millis()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * \brief Microseconds from an arbitrary start, wraps as on Arduino
+ */
+static inline uint32_t micros()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#define DEC 10
+#define HEX 16
+
+/**
+ * \brief Minimal Print to a stdio stream, enough for uRTCLibTrace::dump()
+ */
+class Print
+{
+public:
+	Print(FILE *stream = stdout) : _stream(stream) {}
+	void print(const char *s) { fputs(s, _stream); }
+	void print(const char c) { fputc(c, _stream); }
+	void print(const unsigned long n, const int base = DEC) { fprintf(_stream, base == HEX ? "%lX" : "%lu", n); }
+	void print(const unsigned int n, const int base = DEC) { print((unsigned long)n, base); }
+	void print(const int n, const int base = DEC) { print((long)n, base); }
+	void print(const long n, const int base = DEC) { fprintf(_stream, base == HEX ? "%lX" : "%ld", n); }
+	void println(const char *s = "") { print(s); print('\n'); }
+
+private:
+	FILE *_stream;
+};
+
+/**
+ * \brief ioctl() used for I2C transfers; replace it to run uRTCLib on a fake bus
+ */
+extern int (*uRTCLibIoctl)(int, unsigned long, void *);
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * In-place DateTime arithmetic (addSeconds(), addDays(), += and -= TimeSpan) against unixtime arithmetic.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <random>
+#include "uRTCLib.h"
+#include "test.h"
+
+static bool same(const DateTime &a, const uint32_t unixtime)
+{
+	DateTime b(unixtime);
+	return a.unixtime() == unixtime && a.dayOfTheWeek() == b.dayOfTheWeek() && a.year() == b.year() && a.month() == b.month() && a.day() == b.day();
+}
+
+int main()
+{
+	std::mt19937 rng(1);
+	const int32_t steps[] = {0, 1, 7, 59, 60, 61, 3599, 3600, 86399, 86400, 86401, -1, -59, -60, -86399, -86400, -86401, 2678400, -2678400, 31536000, -31536000};
+	// 2000-02-10 to 2099-11-20, so every step below stays in range
+	const uint32_t low = SECONDS_FROM_1970_TO_2000 + 40 * 86400, span = 3155760000UL - 80 * 86400;
+
+	for (long i = 0; i < 1000000; i++)
+	{
+		uint32_t unixtime = low + rng() % span;
+		int32_t seconds = i % 3 ? steps[rng() % (sizeof(steps) / sizeof(steps[0]))] : (int32_t)(rng() % 10000000) - 5000000;
+		DateTime a(unixtime);
+		a.addSeconds(seconds);
+		CHECK(same(a, unixtime + seconds));
+
+		int16_t days = (int16_t)(rng() % 121) - 60;
+		DateTime b(unixtime);
+		b.addDays(days);
+		CHECK(same(b, unixtime + days * 86400L));
+
+		DateTime c(unixtime);
+		c += TimeSpan(seconds);
+		CHECK(same(c, unixtime + seconds));
+		c -= TimeSpan(seconds);
+		CHECK(same(c, unixtime));
+	}
+
+	// Long day steps: over 24855 days, days * 86400 no longer fits in a signed 32-bit long
+	DateTime start(2000, 1, 1, 6, 30, 0);
+	DateTime far(start);
+	far.addDays(32767);
+	CHECK(same(far, start.unixtime() + 32767UL * 86400));
+	CHECK(far.year() == 2089 && far.month() == 9 && far.day() == 17 && far.hour() == 6);
+	far.addDays(-32767);
+	CHECK(far == start);
+	DateTime late(2099, 12, 31);
+	late.addDays(-25000);
+	CHECK(same(late, DateTime(2099, 12, 31).unixtime() - 25000UL * 86400));
+
+	return TEST_RESULT;
+}
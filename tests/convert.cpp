@@ -0,0 +1,81 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * DateTime::toCivil() and DateTime::toUnix() must match DateTime(uint32_t) and unixtime() bit for bit.
+ * Built twice, without and with -msse4.1, so both the scalar and the SSE4.1 paths are checked.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <random>
+#include <vector>
+#include "uRTCLib.h"
+#include "test.h"
+
+static bool same(const DateTime &a, const DateTime &b)
+{
+	return a.year() == b.year() && a.month() == b.month() && a.day() == b.day() && a.hour() == b.hour() && a.minute() == b.minute() && a.second() == b.second() && a.dayOfTheWeek() == b.dayOfTheWeek();
+}
+
+int main()
+{
+#if defined(__SSE4_1__)
+	puts("SSE4.1 kernels");
+#else
+	puts("scalar");
+#endif
+
+	// t / 86400 == (t >> 7) / 675 by magic number, over the whole shifted range
+	for (uint64_t x = 0; x < (1ULL << 25); x++)
+	{
+		if (((x * 3257812231ULL) >> 41) != x / 675)
+		{
+			CHECK(false);
+			break;
+		}
+	}
+
+	// Every 997th second of the uint32_t range, every second around 2000-01-01 and the last one.
+	// Odd sizes leave a scalar tail after the 4-lane blocks.
+	std::vector<uint32_t> unixtimes;
+	for (uint64_t t = 0; t <= 0xFFFFFFFFULL; t += 997)
+	{
+		unixtimes.push_back(t);
+	}
+	for (uint32_t t = SECONDS_FROM_1970_TO_2000 - 100000; t != SECONDS_FROM_1970_TO_2000 + 100001; t++)
+	{
+		unixtimes.push_back(t);
+	}
+	unixtimes.push_back(0xFFFFFFFF);
+
+	std::vector<DateTime> civil(unixtimes.size());
+	DateTime::toCivil(unixtimes.data(), civil.data(), unixtimes.size());
+	for (size_t i = 0; i < unixtimes.size(); i++)
+	{
+		CHECK(same(civil[i], DateTime(unixtimes[i])));
+	}
+
+	std::vector<uint32_t> back(civil.size());
+	DateTime::toUnix(civil.data(), back.data(), civil.size());
+	for (size_t i = 0; i < civil.size(); i++)
+	{
+		CHECK(back[i] == civil[i].unixtime());
+	}
+
+	// Any field values, including out of range ones, as DateTime does not validate them
+	std::mt19937 rng(1);
+	std::vector<DateTime> random;
+	for (int i = 0; i < 100003; i++)
+	{
+		random.push_back(DateTime(rng() % 256, 1 + rng() % 12, 1 + rng() % 31, rng() % 24, rng() % 60, rng() % 60));
+	}
+	std::vector<uint32_t> randomUnix(random.size());
+	DateTime::toUnix(random.data(), randomUnix.data(), random.size());
+	for (size_t i = 0; i < random.size(); i++)
+	{
+		CHECK(randomUnix[i] == random[i].unixtime());
+	}
+
+	return TEST_RESULT;
+}
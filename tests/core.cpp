@@ -0,0 +1,75 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibCore on its own: date and time types and BCD codec, no Arduino nor I2C.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "test.h"
+
+// Compile time folding, which a user-provided copy constructor would break
+static constexpr DateTime built(__DATE__, __TIME__);
+static_assert(built.year() >= 2024 && built.month() >= 1 && built.month() <= 12, "__DATE__ folds");
+static_assert(DateTime(2024, 1, 1).unixtime() == 1704067200UL, "unixtime() folds");
+static_assert(DateTime(DateTime(2024, 2, 29, 12)).dayOfTheWeek() == 4, "copies fold");
+static_assert(TimeSpan(90).minutes() == 1 && TimeSpan(TimeSpan(90)).seconds() == 30, "TimeSpan folds");
+static_assert((TimeSpan(1, 0, 0, 0) - TimeSpan(60)).totalseconds() == 86340, "TimeSpan arithmetic folds");
+
+static uint8_t monthDays(const uint16_t year, const uint8_t month)
+{
+	static const uint8_t days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	return days[month - 1] + (month == 2 && year % 4 == 0);
+}
+
+int main()
+{
+	// Every day from 2000 to 2099, at a time of day that changes each day
+	uint32_t unixtime = SECONDS_FROM_1970_TO_2000;
+	uint8_t dayOfTheWeek = 6; // 2000-01-01 was Saturday
+	for (uint16_t year = 2000; year < 2100; year++)
+	{
+		for (uint8_t month = 1; month <= 12; month++)
+		{
+			for (uint8_t day = 1; day <= monthDays(year, month); day++)
+			{
+				uint32_t time = unixtime + (unixtime / 86400 * 7919) % 86400;
+				DateTime dt(time);
+				CHECK(dt.year() == year && dt.month() == month && dt.day() == day);
+				CHECK(dt.dayOfTheWeek() == dayOfTheWeek);
+				CHECK(DateTime(year, month, day, dt.hour(), dt.minute(), dt.second()).unixtime() == time);
+				unixtime += 86400;
+				dayOfTheWeek = (dayOfTheWeek + 1) % 7;
+			}
+		}
+	}
+	CHECK(unixtime == DateTime(2100, 1, 1).unixtime());
+
+	// BCD codec against a byte at a time reference, every valid value
+	for (uint8_t value = 0; value < 100; value++)
+	{
+		uint8_t bcd = uRTCLibBcd::bin2bcd(value);
+		CHECK(bcd == ((value / 10) << 4 | value % 10));
+		CHECK(uRTCLibBcd::bcd2bin4((uint32_t)bcd * 0x01010101UL) == (uint32_t)value * 0x01010101UL);
+	}
+
+	// 12h mode, control bits and Century on a time block
+	uint8_t block[7] = {0b10000101, 0x59, 0b01110010, 0x03, 0x31, 0b10010010, 0x99}; // CH, 12 PM, Century
+	uRTCLibBcd::decodeTimeBlock(block);
+	CHECK(block[0] == 5 && block[1] == 59 && block[2] == 12 && block[3] == 3 && block[4] == 31 && block[5] == 12 && block[6] == 199);
+	uint8_t midnight[7] = {0x00, 0x00, 0b01010010, 0x01, 0x01, 0x01, 0x00}; // 12 AM
+	uRTCLibBcd::decodeTimeBlock(midnight);
+	CHECK(midnight[2] == 0);
+
+	// Century bit years print in full
+	DateTime late(2150, 7, 4, 5, 6, 7);
+	char text[] = "YYYY-MM-DD YY";
+	CHECK(strcmp(late.toString(text), "2150-07-04 50") == 0);
+	CHECK(late.timestamp() == "2150-07-04T05:06:07" && late.timestamp(DateTime::TIMESTAMP_DATE) == "2150-07-04");
+	char last[] = "YYYY";
+	CHECK(strcmp(DateTime(2199, 12, 31).toString(last), "2199") == 0);
+
+	return TEST_RESULT;
+}
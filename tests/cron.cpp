@@ -0,0 +1,62 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibCron: parsing, next() against a minute by minute matches() scan, and alarm registers from alarmSetCron().
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	const char *valid[] = {"*/15 8-18 * * 1-5", "0 0 29 2 *", "30 4 1,15 * 5", "* * * * *", "5-59/20 */6 */10 1-12/3 *",
+												 "0 12 13 * 5", "59 23 31 12 7", "0 0 * * 0", "0 0 30 2 *"};
+	const char *invalid[] = {"17 3 L * *", "60 * * * *", "1,2,3 4 5 6 7 8", "* * * *", "*/0 * * * *", "5-3 * * * *", ""};
+	uRTCLibCron cron;
+
+	for (const char *expression : invalid)
+	{
+		CHECK(!cron.parse(expression));
+		CHECK(!cron.matches(DateTime(2027, 1, 1)));
+	}
+
+	// 2027-06-01 to 2028-07-01, with Feb 29 2028: next() must land on every matching minute, and only on them
+	const uint32_t end = DateTime(2028, 7, 1).unixtime();
+	for (const char *expression : valid)
+	{
+		CHECK(cron.parse(expression));
+		DateTime found;
+		bool more = cron.next(DateTime(2027, 5, 31, 23, 59, 30), found);
+		for (DateTime t(2027, 6, 1, 0, 0, 0); t.unixtime() < end; t.addSeconds(60))
+		{
+			if (!cron.matches(t))
+				continue;
+			CHECK(more && found == t);
+			more = cron.next(t, found);
+		}
+		CHECK(!more || found.unixtime() >= end);
+	}
+	DateTime never;
+	CHECK(cron.parse("0 0 30 2 *") && !cron.next(DateTime(2027, 1, 1), never));
+
+	uRTCLibCron work("*/15 8-18 * * 1-5");
+	CHECK(work.matches(DateTime(2026, 10, 19, 8, 45, 0)));
+	CHECK(!work.matches(DateTime(2026, 10, 18, 8, 45, 0)));
+	CHECK(!work.matches(DateTime(2026, 10, 19, 19, 0, 0)));
+	CHECK(!work.matches(DateTime(2026, 10, 19, 8, 46, 0)));
+	// Both day fields restricted: either one matches
+	uRTCLibCron friday("0 12 13 * 5");
+	CHECK(friday.matches(DateTime(2026, 11, 13, 12, 0, 0)) && friday.matches(DateTime(2026, 10, 16, 12, 0, 0)) && friday.matches(DateTime(2026, 10, 13, 12, 0, 0)));
+	CHECK(uRTCLibCron("0 0 * * 7").matches(DateTime(2026, 10, 18)));
+
+	// Saturday 10:00: next run is Monday 08:00, alarm 2 set to day of month 19, 08:00
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	CHECK(rtc.alarmSetCron(URTCLIB_ALARM_2, work, DateTime(2026, 10, 17, 10, 0, 0)));
+	CHECK(stub.regs[0x0B] == 0x00 && stub.regs[0x0C] == 0x08 && stub.regs[0x0D] == 0x19);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,103 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibDrift on a simulated DS1307 running 80 ppm slow, synced weekly for 120 days: corrected time error, RTC
+ * rewrites and state kept in RTC RAM.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+static const double rate = 1 - 80e-6; // RTC seconds per true second
+static double rtcBase, trueBase;		 // RTC time set by last write, and true time then
+static unsigned long rewrites = 0;
+
+/**
+ * \brief RTC time in registers
+ */
+static uint32_t registers()
+{
+	return DateTime(2000 + (stub.regs[6] >> 4) * 10 + (stub.regs[6] & 0x0F), (stub.regs[5] >> 4) * 10 + (stub.regs[5] & 0x0F),
+									(stub.regs[4] >> 4) * 10 + (stub.regs[4] & 0x0F), (stub.regs[2] >> 4) * 10 + (stub.regs[2] & 0x0F),
+									(stub.regs[1] >> 4) * 10 + (stub.regs[1] & 0x0F), (stub.regs[0] >> 4) * 10 + (stub.regs[0] & 0x0F))
+			.unixtime();
+}
+
+/**
+ * \brief Sets registers as RTC runs at true time t
+ */
+static void run(const double t)
+{
+	stubSetTime((uint32_t)(rtcBase + (t - trueBase) * rate));
+}
+
+/**
+ * \brief Takes RTC time written by the library, if any, as new base
+ */
+static void written(const double t, const uint32_t before)
+{
+	uint32_t now = registers();
+	if (now != before)
+	{
+		rtcBase = now;
+		trueBase = t;
+		rewrites++;
+	}
+}
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS1307);
+	uRTCLibDrift drift(rtc, 2, 0);
+	const double start = DateTime(2026, 1, 1).unixtime();
+	double worst = 0;
+
+	rtcBase = trueBase = start;
+	for (double t = start; t < start + 120 * 86400.0; t += 600)
+	{
+		uint32_t before;
+		if ((long)(t - start) % (7 * 86400L) == 0)
+		{
+			run(t);
+			before = registers();
+			drift.sync(DateTime((uint32_t)t));
+			written(t, before);
+		}
+		run(t);
+		before = registers();
+		double error = (double)drift.now().unixtime() - t;
+		written(t, before);
+		if (t > start + 15 * 86400.0 && (error > worst || -error > worst))
+			worst = error < 0 ? -error : error;
+	}
+
+	// Rate learned within 2 syncs, with sub-second rewrite losses absorbed; RTC is only rewritten over 2 s error
+	CHECK(worst <= 2);
+	CHECK(drift.ppb() > 60000 && drift.ppb() < 140000);
+	CHECK(rewrites > 0 && rewrites < 120 * 86400.0 * 80e-6); // less than one per second of total drift
+
+	// State survives a MCU reset
+	uRTCLibDrift reloaded(rtc, 2, 0);
+	CHECK(reloaded.load() && reloaded.ppb() == drift.ppb());
+	uRTCLibDrift nowhere(rtc, 2);
+	CHECK(!nowhere.load());
+
+	// State moves in one transaction, saved once per sync even when RTC gets rewritten
+	unsigned long reads = stub.reads;
+	CHECK(reloaded.load() && stub.reads == reads + 1);
+	unsigned long writes = stub.writes;
+	rtc.adjust(DateTime(2026, 6, 1));
+	unsigned long adjustWrites = stub.writes - writes;
+	writes = stub.writes;
+	reloaded.sync(DateTime(2026, 6, 1));
+	CHECK(stub.writes == writes + 1);
+	writes = stub.writes;
+	reloaded.sync(DateTime(2026, 6, 2));
+	CHECK(registers() == DateTime(2026, 6, 2).unixtime() && stub.writes == writes + adjustWrites + 1);
+
+	return TEST_RESULT;
+}
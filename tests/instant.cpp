@@ -0,0 +1,59 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Duration and Instant: split(), saturating arithmetic and conversions, against 128-bit reference arithmetic
+ * (GCC and Clang __int128).
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <random>
+#include "uRTCLib.h"
+#include "test.h"
+
+static int64_t saturated(const __int128 value)
+{
+	return value > URTCLIB_MS_MAX ? URTCLIB_MS_MAX : value < URTCLIB_MS_MIN ? URTCLIB_MS_MIN : (int64_t)value;
+}
+
+int main()
+{
+	std::mt19937_64 rng(3);
+
+	for (long i = 0; i < 1000000; i++)
+	{
+		// Random magnitudes, from a few milliseconds to the whole int64_t range
+		int64_t v = (int64_t)rng() >> (rng() % 64), w = (int64_t)rng() >> (rng() % 64);
+		if (i % 7 == 0)
+			v = -v;
+
+		Duration::Parts parts = Duration(v).split();
+		__int128 magnitude = v < 0 ? -(__int128)v : v;
+		int64_t days = (int64_t)(magnitude / 86400000), rest = (int64_t)(magnitude % 86400000);
+		CHECK(parts.negative == (v < 0) && parts.days == (uint32_t)(days > 0xFFFFFFFFLL ? 0xFFFFFFFFLL : days));
+		CHECK(parts.hours == rest / 3600000 && parts.minutes == rest / 60000 % 60 && parts.seconds == rest / 1000 % 60 && parts.milliseconds == rest % 1000);
+
+		CHECK((Duration(v) + Duration(w)).totalMilliseconds() == saturated((__int128)v + w));
+		CHECK((Duration(v) - Duration(w)).totalMilliseconds() == saturated((__int128)v - w));
+		CHECK((Instant(v) + Duration(w)).unixMilliseconds() == saturated((__int128)v + w));
+		CHECK((Instant(v) - Instant(w)).totalMilliseconds() == saturated((__int128)v - w));
+
+		int32_t seconds = (int32_t)rng();
+		CHECK(Duration(TimeSpan(seconds)).toTimeSpan().totalseconds() == seconds);
+
+		uint32_t t = SECONDS_FROM_1970_TO_2000 + rng() % (0xFFFFFFFFUL - SECONDS_FROM_1970_TO_2000);
+		uint16_t ms = rng() % 1000;
+		Instant instant(DateTime(t), ms);
+		CHECK(instant.toDateTime().unixtime() == t && instant.millisecond() == ms);
+		CHECK((instant - Instant(DateTime(t))).totalMilliseconds() == ms);
+	}
+
+	CHECK((-Duration(URTCLIB_MS_MIN)).totalMilliseconds() == URTCLIB_MS_MAX); // saturated
+	// Durations truncate towards zero into TimeSpan, instants floor to their second
+	CHECK(Duration(-1500).toTimeSpan().totalseconds() == -1 && Instant(-1).millisecond() == 999);
+	Duration::Parts parts = Duration(-((int64_t)3 * 86400000 + 4 * 3600000 + 5 * 60000 + 6007)).split();
+	CHECK(parts.negative && parts.days == 3 && parts.hours == 4 && parts.minutes == 5 && parts.seconds == 6 && parts.milliseconds == 7);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,97 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Linux i2c-dev transport on a fake file descriptor: uRTCLibIoctl is replaced by a simulated RTC answering
+ * I2C_RDWR requests. Links the uRTCLib CMake target as is.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <errno.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "uRTCLib.h"
+#include "test.h"
+
+#define FAKE_FD 42
+
+static uint8_t regs[256];
+static int transfers, badRequests;
+
+static int fakeIoctl(int fd, unsigned long request, void *arg)
+{
+	if (fd != FAKE_FD || request != I2C_RDWR)
+	{
+		badRequests++;
+		errno = EINVAL;
+		return -1;
+	}
+	transfers++;
+	i2c_rdwr_ioctl_data *transfer = (i2c_rdwr_ioctl_data *)arg;
+	uint8_t pointer = 0;
+	for (unsigned i = 0; i < transfer->nmsgs; i++)
+	{
+		i2c_msg &message = transfer->msgs[i];
+		if (message.addr != 0x68)
+		{
+			errno = ENXIO;
+			return -1;
+		}
+		if (message.flags & I2C_M_RD)
+		{
+			for (int k = 0; k < message.len; k++)
+				message.buf[k] = regs[pointer++];
+		}
+		else
+		{
+			pointer = message.buf[0];
+			for (int k = 1; k < message.len; k++)
+				regs[pointer++] = message.buf[k];
+		}
+	}
+	return transfer->nmsgs;
+}
+
+int main()
+{
+	uRTCLibIoctl = fakeIoctl;
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3232);
+	rtc.i2cAttach(FAKE_FD);
+
+	// Burst write and read, one ioctl each
+	rtc.adjust(DateTime(2026, 10, 18, 13, 45, 7));
+	CHECK(transfers == 1);
+	CHECK(regs[0] == 0x07 && regs[1] == 0x45 && regs[2] == 0x13 && regs[3] == 1 && regs[4] == 0x18 && regs[5] == 0x10 && regs[6] == 0x26);
+	transfers = 0;
+	CHECK(rtc.now() == DateTime(2026, 10, 18, 13, 45, 7));
+	CHECK(transfers == 1);
+	CHECK(rtc.nowUnix() == DateTime(2026, 10, 18, 13, 45, 7).unixtime());
+
+	// RAM at its DS3232 offset
+	CHECK(rtc.ramWrite(2, 0x55));
+	CHECK(regs[0x16] == 0x55 && rtc.ramRead(2) == 0x55);
+
+	// Temperature, 25.25 degrees
+	regs[0x11] = 25;
+	regs[0x12] = 0b01000000;
+	CHECK(rtc.temp() == 2525);
+
+	// NACK: access fails, cached time is kept
+	rtc.set_rtc_address(0x50);
+	regs[0] = 0x08;
+	CHECK(!rtc.refresh());
+	CHECK(rtc.second() == 7);
+	rtc.set_rtc_address(0x68);
+	CHECK(rtc.refresh() && rtc.second() == 8);
+
+	CHECK(badRequests == 0);
+
+	// Detached: accesses fail, nothing reaches the bus
+	rtc.i2cClose();
+	transfers = 0;
+	CHECK(!rtc.refresh());
+	CHECK(transfers == 0);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,71 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Bus lock policy under thread contention: uRTCLib objects on several threads share one bus, built with
+ * URTCLIB_LOCK_POLICY=uRTCLibUserLock on a recursive mutex. Without it, register pointers and transfers interleave.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+#define ITERATIONS 200000
+
+static std::recursive_mutex bus;
+
+void uRTCLibUserLock::lock() { bus.lock(); }
+
+void uRTCLibUserLock::unlock() { bus.unlock(); }
+
+int main()
+{
+	uRTCLib clock(0x68, URTCLIB_MODEL_DS3232), logger(0x68, URTCLIB_MODEL_DS3232), settings(0x68, URTCLIB_MODEL_DS3232);
+	stubSetTime(DateTime(2026, 10, 18, 12, 15, 30).unixtime());
+	std::atomic<bool> stop(false);
+	std::atomic<unsigned long> clockErrors(0), loggerErrors(0), settingsErrors(0);
+
+	// Time reads: one transaction each, fixed time
+	std::thread clockThread([&] {
+		for (int i = 0; i < ITERATIONS; i++)
+		{
+			if (clock.now() != DateTime(2026, 10, 18, 12, 15, 30))
+				clockErrors++;
+		}
+		stop = true;
+	});
+
+	// RAM write and read back, each thread on its own address
+	std::thread loggerThread([&] {
+		for (uint8_t value = 0; !stop; value++)
+		{
+			if (!logger.ramWrite(5, value) || logger.ramRead(5) != value)
+				loggerErrors++;
+		}
+	});
+
+	// Read-modify-write of control registers, multi-step under one lock
+	std::thread settingsThread([&] {
+		for (uint8_t value = 0; !stop; value++)
+		{
+			settings.ramWrite(9, value);
+			settings.out32KHzSet(value & 1);
+			if (settings.ramRead(9) != value || settings.out32KHz() != (value & 1))
+				settingsErrors++;
+		}
+	});
+
+	clockThread.join();
+	loggerThread.join();
+	settingsThread.join();
+	CHECK(clockErrors == 0);
+	CHECK(loggerErrors == 0);
+	CHECK(settingsErrors == 0);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,39 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Smallest build, every URTCLIB_NO_* feature removed: what is left still reads, writes and checks RTC time.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+
+	rtc.adjust(DateTime(2026, 10, 21, 8, 9, 10));
+	CHECK(rtc.now() == DateTime(2026, 10, 21, 8, 9, 10));
+	CHECK(rtc.nowUnix() == DateTime(2026, 10, 21, 8, 9, 10).unixtime());
+	CHECK(rtc.nowPacked() == DateTime(2026, 10, 21, 8, 9, 10).packed());
+
+	// One transaction per read
+	unsigned long reads = stub.reads;
+	rtc.now();
+	CHECK(stub.reads == reads + 1);
+
+	// Oscillator stop flag
+	stub.regs[0x0F] = 0x80;
+	CHECK(rtc.lostPower());
+	rtc.lostPowerClear();
+	CHECK(!rtc.lostPower());
+
+	// A missing RTC reads as 2000-01-01 00:00:00
+	stub.address = 0x50;
+	CHECK(rtc.nowUnix() == SECONDS_FROM_1970_TO_2000 && rtc.now().unixtime() == SECONDS_FROM_1970_TO_2000);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,46 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * DateTime::packed() and uRTCLib::nowPacked(): round trip, ordering and saturation from 2064 on.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	uint32_t previous = 0;
+
+	// Every 7 hours and 13 seconds from 2000 to 2099, as DateTime and as read from RTC registers
+	for (uint32_t unixtime = SECONDS_FROM_1970_TO_2000; unixtime < DateTime(2100, 1, 1).unixtime(); unixtime += 25213)
+	{
+		DateTime dt(unixtime);
+		uint32_t packed = dt.packed();
+		stubSetTime(unixtime);
+		CHECK(rtc.nowPacked() == packed);
+		CHECK(packed >= previous);
+		if (dt.year() < 2064)
+		{
+			CHECK(DateTime::unpack(packed) == dt);
+			CHECK(packed > previous || unixtime == SECONDS_FROM_1970_TO_2000);
+		}
+		else
+		{
+			CHECK(packed == URTCLIB_PACKED_MAX);
+		}
+		previous = packed;
+	}
+	CHECK(DateTime::unpack(URTCLIB_PACKED_MAX) == DateTime(2063, 12, 31, 23, 59, 59));
+	CHECK(DateTime(2063, 12, 31, 23, 59, 59).packed() == URTCLIB_PACKED_MAX);
+
+	// Century bit: year 2150 is read as offset 150
+	rtc.adjust(DateTime(2150, 6, 1));
+	CHECK(rtc.nowPacked() == URTCLIB_PACKED_MAX);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,96 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * DateTimeRange over days, ISO weeks and months, both directions, against unixtime stepping, and backward walks
+ * ending at 2000-01-01.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "test.h"
+
+static long count(const DateTime &from, const DateTime &to, DateTimeRange::rangeUnit unit, DateTime &last)
+{
+	long n = 0;
+	for (DateTime d : DateTimeRange(from, to, unit))
+	{
+		last = d;
+		if (++n > 100000)
+			break; // does not terminate
+	}
+	return n;
+}
+
+int main()
+{
+	DateTime a(2020, 2, 27, 13, 5, 0), b(2030, 3, 2, 1, 0, 0), last;
+
+	// Days, against unixtime stepping
+	uint32_t t = DateTime(2020, 2, 27).unixtime();
+	for (DateTime d : DateTimeRange(a, b))
+	{
+		CHECK(d.unixtime() == t && d.dayOfTheWeek() == DateTime(t).dayOfTheWeek());
+		t += SECONDS_PER_DAY;
+	}
+	CHECK(t == DateTime(2030, 3, 3).unixtime());
+	t = DateTime(2030, 3, 2).unixtime();
+	for (DateTime d : DateTimeRange(b, a))
+	{
+		CHECK(d.unixtime() == t);
+		t -= SECONDS_PER_DAY;
+	}
+	CHECK(t == DateTime(2020, 2, 26).unixtime());
+	CHECK(count(a, a, DateTimeRange::RANGE_DAYS, last) == 1);
+
+	// Weeks: every element is a Monday
+	long n = 0;
+	for (DateTime d : DateTimeRange(DateTime(2026, 10, 18), DateTime(2027, 1, 6), DateTimeRange::RANGE_WEEKS))
+	{
+		CHECK(d.dayOfTheWeek() == 1);
+		CHECK(n || (d.month() == 10 && d.day() == 12));
+		CHECK(!n || d.unixtime() - last.unixtime() == 7 * SECONDS_PER_DAY);
+		last = d;
+		n++;
+	}
+	CHECK(last == DateTime(2027, 1, 4));
+	CHECK(count(DateTime(2027, 1, 6), DateTime(2026, 10, 18), DateTimeRange::RANGE_WEEKS, last) == 13 && last == DateTime(2026, 10, 12));
+
+	// Months, with day clamping in addMonths()
+	n = 0;
+	for (DateTime d : DateTimeRange(DateTime(2023, 11, 30), DateTime(2025, 2, 1), DateTimeRange::RANGE_MONTHS))
+	{
+		CHECK(d.day() == 1 && d.dayOfTheWeek() == DateTime(d.unixtime()).dayOfTheWeek());
+		last = d;
+		n++;
+	}
+	CHECK(n == 16 && last == DateTime(2025, 2, 1));
+	CHECK(count(DateTime(2025, 2, 1), DateTime(2023, 11, 30), DateTimeRange::RANGE_MONTHS, last) == 16 && last == DateTime(2023, 11, 1));
+	DateTime j(2024, 1, 31, 7, 0, 0);
+	j.addMonths(1);
+	CHECK(j == DateTime(2024, 2, 29, 7, 0, 0));
+	j.addMonths(-14);
+	CHECK(j == DateTime(2022, 12, 29, 7, 0, 0));
+
+	// Past 2127, where a 16-bit key would wrap
+	CHECK(count(DateTime(2127, 12, 25), DateTime(2128, 1, 10), DateTimeRange::RANGE_DAYS, last) == 17 && last == DateTime(2128, 1, 10));
+	CHECK(count(DateTime(2128, 1, 10), DateTime(2127, 12, 25), DateTimeRange::RANGE_DAYS, last) == 17 && last == DateTime(2127, 12, 25));
+	CHECK(count(DateTime(2127, 6, 15), DateTime(2128, 6, 15), DateTimeRange::RANGE_MONTHS, last) == 13 && last == DateTime(2128, 6, 1));
+	CHECK(count(DateTime(2127, 12, 1), DateTime(2128, 1, 31), DateTimeRange::RANGE_WEEKS, last) == 9 && last.dayOfTheWeek() == 1);
+
+	// Backward walks down to 2000-01-01, the first representable day
+	CHECK(count(DateTime(2000, 1, 3), DateTime(2000, 1, 1), DateTimeRange::RANGE_DAYS, last) == 3 && last == DateTime(2000, 1, 1));
+	CHECK(count(DateTime(2000, 3, 15), DateTime(2000, 1, 1), DateTimeRange::RANGE_MONTHS, last) == 3 && last == DateTime(2000, 1, 1));
+	CHECK(count(DateTime(2000, 1, 1), DateTime(2000, 1, 1), DateTimeRange::RANGE_MONTHS, last) == 1);
+	// The week containing 2000-01-01 starts on 1999-12-27, so it is clamped to 2000-01-01, both directions
+	CHECK(count(DateTime(2000, 1, 20), DateTime(2000, 1, 2), DateTimeRange::RANGE_WEEKS, last) == 4 && last == DateTime(2000, 1, 1));
+	CHECK(count(DateTime(2000, 1, 2), DateTime(2000, 1, 20), DateTimeRange::RANGE_WEEKS, last) == 4 && last == DateTime(2000, 1, 17));
+	for (DateTime d : DateTimeRange(DateTime(2000, 1, 2), DateTime(2000, 1, 20), DateTimeRange::RANGE_WEEKS))
+		CHECK(d == DateTime(2000, 1, 1) || d.dayOfTheWeek() == 1);
+	j = DateTime(2000, 2, 29);
+	j.addMonths(-3);
+	CHECK(j == DateTime(2000, 1, 29));
+
+	return TEST_RESULT;
+}
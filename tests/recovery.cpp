@@ -0,0 +1,85 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Bus recovery soak: 5 million reads and writes with random NACKs on data, short reads and a slave holding SDA low for 1
+ * to 12 clocks. Open drain lines must never be driven high, and an address NACK must not start a recovery. Prints
+ * mean and worst simulated time per faulty call, recovery included.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <stdio.h>
+#include <random>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	std::mt19937 rng(7);
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	rtc.set_bus_pins(STUB_SDA_PIN, STUB_SCL_PIN);
+	const DateTime time(2024, 5, 6, 7, 8, 9);
+	static const char *const names[] = {"NACK on data", "short read", "SDA held low"};
+	unsigned long count[3] = {0, 0, 0}, worst[3] = {0, 0, 0};
+	double total[3] = {0, 0, 0};
+
+	for (long i = 0; i < 5000000; i++)
+	{
+		uint8_t stuck = 0, fault = rng() % 100;
+		if (fault < 5)
+			stub.fault = STUB_FAULT_NACK_DATA;
+		else if (fault < 10)
+			stub.fault = STUB_FAULT_SHORT_READ;
+		else if (fault < 15)
+			stub.stuck = stuck = 1 + rng() % 12;
+
+		unsigned long start = stub.elapsedMicros;
+		bool ok;
+		if (i % 4)
+		{
+			ok = rtc.now() == time;
+		}
+		else
+		{
+			stubSetTime(0);
+			rtc.adjust(time);
+			ok = stub.regs[0] == 0x09 && stub.regs[6] == 0x24;
+			stubSetTime(time.unixtime());
+		}
+		// 9 clocks shift out any byte, plus the one of the STOP; anything longer is a broken slave
+		CHECK(ok == (stuck <= 10));
+		if (fault < 15)
+		{
+			uint8_t kind = fault / 5;
+			unsigned long elapsed = stub.elapsedMicros - start;
+			count[kind]++;
+			total[kind] += elapsed;
+			if (elapsed > worst[kind])
+				worst[kind] = elapsed;
+		}
+		stub.fault = STUB_FAULT_NONE;
+		stub.stuck = 0;
+	}
+	CHECK(stub.drivenHigh == 0);
+	CHECK(stub.begins > 0 && stub.wireOn);
+	printf("fault, calls, mean us, worst us\n");
+	for (uint8_t kind = 0; kind < 3; kind++)
+	{
+		printf("%s, %lu, %.1f, %lu\n", names[kind], count[kind], total[kind] / count[kind], worst[kind]);
+		CHECK(count[kind] > 0 && worst[kind] < 2000);
+	}
+
+	// Missing RTC: no recovery, nothing clocked
+	unsigned long begins = stub.begins, clocks = stub.clocks;
+	stub.address = 0x50;
+	CHECK(!rtc.refresh());
+	CHECK(stub.begins == begins && stub.clocks == clocks);
+	stub.address = 0x68;
+
+	// Called at boot on a free bus: only the STOP is sent
+	CHECK(rtc.busRecover() && stub.clocks == clocks + 1 && stub.drivenHigh == 0);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,43 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Time registers on the simulated RTC: adjust() / now() round trip, 12h mode and failed reads.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+
+	rtc.adjust(DateTime(2026, 10, 21, 8, 9, 10));
+	CHECK(stub.regs[0] == 0x10 && stub.regs[1] == 0x09 && stub.regs[2] == 0x08 && stub.regs[3] == 4);
+	CHECK(stub.regs[4] == 0x21 && stub.regs[5] == 0x10 && stub.regs[6] == 0x26);
+	CHECK(rtc.now() == DateTime(2026, 10, 21, 8, 9, 10));
+	CHECK(rtc.refresh() && rtc.hour() == 8 && rtc.dayOfWeek() == 4);
+
+	// One transaction per read, whatever happened before
+	unsigned long reads = stub.reads;
+	rtc.now();
+	CHECK(stub.reads == reads + 1);
+
+	stub.regs[2] = 0b01110001; // 11 PM, 12h mode
+	CHECK(rtc.now().hour() == 23);
+
+	// A short read fails at once instead of waiting for a timeout, and keeps cached time
+	stubSetTime(DateTime(2030, 1, 2, 3, 4, 5).unixtime());
+	CHECK(rtc.refresh());
+	stub.fault = STUB_FAULT_SHORT_READ;
+	unsigned long start = micros();
+	stub.regs[0] = 0x06;
+	CHECK(!rtc.refresh());
+	CHECK(micros() - start < 100000);
+	CHECK(rtc.second() == 5);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,131 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibSnapshot: readers on other threads never see a torn snapshot; uRTCLib publishes every read when built
+ * with URTCLIB_SNAPSHOT, in read order even when several threads read time (URTCLIB_LOCK_POLICY=uRTCLibUserLock).
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+#define PUBLISHES 5000000
+
+static std::recursive_mutex bus;
+
+void uRTCLibUserLock::lock() { bus.lock(); }
+
+void uRTCLibUserLock::unlock() { bus.unlock(); }
+
+static uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+static uint32_t latest = 1700000200;
+static std::atomic<bool> preempted(false);
+static std::thread taskB;
+static std::mutex doneMutex;
+static std::condition_variable doneSignal;
+static bool done;
+
+/**
+ * \brief Clock hook: on first clock read after arming, RTC ticks and task B reads it before the caller goes on
+ */
+static void preempt()
+{
+	if (!preempted.exchange(false))
+		return;
+	stubSetTime(++latest);
+	done = false;
+	taskB = std::thread([] {
+		rtc.nowUnix();
+		std::lock_guard<std::mutex> hold(doneMutex);
+		done = true;
+		doneSignal.notify_one();
+	});
+	// Task B either finishes or waits on the bus lock held by the caller
+	std::unique_lock<std::mutex> hold(doneMutex);
+	doneSignal.wait_for(hold, std::chrono::milliseconds(20), [] { return done; });
+}
+
+int main()
+{
+	// One writer, three readers; every field of a published snapshot is derived from unixtime
+	uRTCLibSnapshot shared;
+	std::atomic<bool> stop(false);
+	std::atomic<unsigned long> torn(0), reads(0);
+	std::vector<std::thread> readers;
+	for (int r = 0; r < 3; r++)
+	{
+		readers.emplace_back([&] {
+			uRTCLibTimeSnapshot snapshot;
+			uint32_t last = 0;
+			while (!stop)
+			{
+				shared.read(snapshot);
+				reads++;
+				if (snapshot.flags && (snapshot.stamp != snapshot.unixtime * 3u || snapshot.millisecond != (uint16_t)(snapshot.unixtime ^ 0x5A5A) || snapshot.unixtime < last))
+					torn++;
+				last = snapshot.unixtime;
+			}
+		});
+	}
+	for (uint32_t i = 1; i <= PUBLISHES; i++)
+	{
+		uRTCLibTimeSnapshot snapshot = {i, i * 3, (uint16_t)(i ^ 0x5A5A), URTCLIB_SNAPSHOT_VALID};
+		shared.publish(snapshot);
+	}
+	stop = true;
+	for (std::thread &reader : readers)
+		reader.join();
+	printf("%lu reads\n", (unsigned long)reads);
+	CHECK(torn == 0);
+
+	// Publication from RTC reads
+	uRTCLibTimeSnapshot snapshot;
+	rtc.snapshot().read(snapshot);
+	CHECK(snapshot.flags == 0);
+
+	stubSetTime(1700000000);
+	rtc.now();
+	rtc.snapshot().read(snapshot);
+	CHECK(snapshot.flags == URTCLIB_SNAPSHOT_VALID && snapshot.unixtime == 1700000000 && snapshot.millisecond == 0);
+
+	stubSetTime(1700000100);
+	CHECK(rtc.nowPacked() == DateTime(1700000100).packed());
+	rtc.snapshot().read(snapshot);
+	CHECK(snapshot.unixtime == 1700000100);
+
+	// Failed read keeps last good time, flagged
+	stub.address = 0x50;
+	stubSetTime(1700000200);
+	rtc.refresh();
+	rtc.snapshot().read(snapshot);
+	CHECK(snapshot.flags == (URTCLIB_SNAPSHOT_VALID | URTCLIB_SNAPSHOT_ERROR) && snapshot.unixtime == 1700000100);
+
+	stub.address = 0x68;
+	rtc.refresh();
+	rtc.snapshot().read(snapshot);
+	CHECK(snapshot.flags == URTCLIB_SNAPSHOT_VALID && snapshot.unixtime == 1700000200);
+
+	// Two tasks reading time: task A is preempted between its read and its publication, task B reads a newer time
+	// meanwhile. B must wait for A on the bus lock, so the newer time is published last
+	stub.onClock = preempt;
+	for (int round = 0; round < 10; round++)
+	{
+		preempted = true;
+		rtc.nowUnix();
+		taskB.join();
+		rtc.snapshot().read(snapshot);
+		CHECK(snapshot.unixtime == latest);
+	}
+	stub.onClock = 0;
+
+	return TEST_RESULT;
+}
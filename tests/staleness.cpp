@@ -0,0 +1,76 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Cached time with a staleness budget (URTCLIB_STALENESS): getters lag RTC by at most 1 second across a year change,
+ * bus reads are bounded by the budget, also while the RTC is missing.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+static const uint32_t base = DateTime(2026, 12, 31, 23, 59, 58).unixtime();
+static unsigned long start;
+
+/**
+ * \brief Sets RTC registers to current time, RTC started at base on start millis()
+ */
+static DateTime run()
+{
+	uint32_t unixtime = base + (millis() - start) / 1000;
+	stubSetTime(unixtime);
+	return DateTime(unixtime);
+}
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	start = millis();
+
+	// RTC missing: getters report zeroes, trying the bus once per budget
+	rtc.setStaleness(2000);
+	stub.address = 0x50;
+	unsigned long transactions = stub.transactions;
+	for (int i = 0; i < 1000; i++)
+	{
+		CHECK(rtc.second() == 0 && rtc.month() == 0 && rtc.year() == 0);
+		delay(7);
+	}
+	CHECK(stub.transactions - transactions == 4); // 7 s
+	CHECK(stub.reads == 0);
+
+	// RTC back: read on next budget
+	stub.address = 0x68;
+	delay(2000);
+	start = millis();
+	run();
+	CHECK(rtc.month() == 12 && rtc.day() == 31 && rtc.second() == 58);
+	CHECK(stub.reads == 1);
+
+	// 5.5 s in 7 ms steps, crossing the year change
+	unsigned long reads = stub.reads;
+	while (millis() - start < 5500)
+	{
+		DateTime truth = run();
+		uint8_t second = rtc.second(), minute = rtc.minute(), hour = rtc.hour(), day = rtc.day(), month = rtc.month(), year = rtc.year();
+		long lag = (long)truth.unixtime() - (long)DateTime(year, month, day, hour, minute, second).unixtime();
+		CHECK(lag >= 0 && lag <= 1);
+		delay(7);
+	}
+	CHECK(stub.reads - reads <= 3);
+	CHECK(rtc.year() == 27 && rtc.month() == 1 && rtc.day() == 1 && rtc.dayOfWeek() == DateTime(2027, 1, 1).dayOfTheWeek() + 1);
+
+	// Budget 0: cache only changes on refresh()
+	rtc.setStaleness(0);
+	reads = stub.reads;
+	delay(3000);
+	run();
+	uint8_t second = rtc.second();
+	delay(1000);
+	CHECK(rtc.second() == second && stub.reads == reads);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,97 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Timestamp streams: uRTCLibStampEncoder output decoded back by both uRTCLibStampDecoder paths, for regular,
+ * jittered, irregular and unordered sequences, plus partial and truncated decodes.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "uRTCLib.h"
+#include "test.h"
+
+int main()
+{
+	std::mt19937 rng(9);
+
+	for (int trial = 0; trial < 3000; trial++)
+	{
+		size_t count = rng() % 3000;
+		std::vector<uint32_t> stamps(count);
+		uint32_t t = rng(), interval = rng() % 1000;
+		for (size_t i = 0; i < count; i++)
+		{
+			switch (trial % 4)
+			{
+			case 0: // regular
+				t += interval;
+				break;
+			case 1: // regular with some jitter
+				t += interval + (rng() % 50 == 0 ? rng() % 5 - 2 : 0);
+				break;
+			case 2: // irregular
+				t += rng() % 600;
+				break;
+			default: // unordered
+				t = rng();
+			}
+			stamps[i] = t;
+		}
+		if (trial == 0)
+		{
+			// A run longer than 0xFFFF stamps
+			count = 200000;
+			stamps.resize(count);
+			for (size_t i = 0; i < count; i++)
+				stamps[i] = 1700000000 + i * 60;
+		}
+
+		std::vector<uint8_t> stream(count * URTCLIB_STAMP_MAX_BYTES + 8);
+		size_t length = 0;
+		uRTCLibStampEncoder encoder;
+		for (size_t i = 0; i < count; i++)
+		{
+			uint8_t bytes = encoder.encode(stamps[i], &stream[length]);
+			CHECK(bytes <= URTCLIB_STAMP_MAX_BYTES);
+			length += bytes;
+		}
+		length += encoder.flush(&stream[length]);
+
+		std::vector<uint32_t> decoded(count + 1);
+		CHECK(uRTCLibStampDecoder::decode(stream.data(), length, decoded.data(), count + 1) == count);
+		CHECK(std::equal(stamps.begin(), stamps.end(), decoded.begin()));
+
+		uRTCLibStampDecoder decoder(stream.data(), length);
+		uint32_t stamp;
+		size_t n = 0;
+		while (decoder.next(stamp) && n < count && stamp == stamps[n])
+			n++;
+		CHECK(n == count && !decoder.next(stamp));
+
+		// Output limit is honoured
+		if (count > 10)
+		{
+			CHECK(uRTCLibStampDecoder::decode(stream.data(), length, decoded.data(), 7) == 7);
+			CHECK(std::equal(stamps.begin(), stamps.begin() + 7, decoded.begin()));
+		}
+
+		// A truncated stream decodes a prefix, reading nothing past its end
+		if (length)
+		{
+			size_t cut = rng() % length;
+			std::vector<uint8_t> truncated(stream.begin(), stream.begin() + cut);
+			size_t m = uRTCLibStampDecoder::decode(truncated.data(), cut, decoded.data(), count + 1);
+			CHECK(m <= count && std::equal(decoded.begin(), decoded.begin() + m, stamps.begin()));
+			uRTCLibStampDecoder partial(truncated.data(), cut);
+			while (partial.next(stamp))
+			{
+			}
+		}
+	}
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,79 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host test stub: the Arduino API used by uRTCLib, with time and pins simulated by stub.cpp. Only for tests/,
+ * Arduino builds never see it.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#ifndef URTCLIB_STUB_ARDUINO_H
+#define URTCLIB_STUB_ARDUINO_H
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef std::string String;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define DEC 10
+#define HEX 16
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+static inline void noInterrupts() {}
+static inline void interrupts() {}
+
+/**
+ * \brief Print on stdout
+ */
+class Print
+{
+public:
+	void print(const char *s) { fputs(s, stdout); }
+	void print(const char c) { fputc(c, stdout); }
+	void print(const unsigned long n, const int base = DEC) { printf(base == HEX ? "%lX" : "%lu", n); }
+	void print(const unsigned int n, const int base = DEC) { print((unsigned long)n, base); }
+	void print(const int n, const int base = DEC) { print((long)n, base); }
+	void print(const long n, const int base = DEC) { printf(base == HEX ? "%lX" : "%ld", n); }
+	void println(const char *s = "") { print(s); print('\n'); }
+};
+
+/**
+ * \brief Serial on stdout
+ */
+class HardwareSerial : public Print
+{
+public:
+	void begin(const unsigned long) {}
+	operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host test stub: Wire on a simulated RTC, see stub.h.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#ifndef URTCLIB_STUB_WIRE_H
+#define URTCLIB_STUB_WIRE_H
+#include "Arduino.h"
+
+/**
+ * \brief Wire subset used by uRTCLib
+ *
+ * Buffers fit a whole DS3232 RAM transfer, as large buffer cores (ESP32, RP2040) do.
+ */
+class TwoWire
+{
+public:
+	void begin();
+	void end();
+	void beginTransmission(const int address);
+	size_t write(const uint8_t data);
+	size_t write(const uint8_t *data, const size_t length);
+	uint8_t endTransmission(const bool stop = true);
+	uint8_t requestFrom(const int address, const int length);
+	int available();
+	int read();
+
+private:
+	uint8_t _address = 0;
+	uint8_t _tx[255];
+	uint8_t _txLength = 0;
+	uint8_t _rx[255];
+	uint8_t _rxLength = 0;
+	uint8_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host test stub implementation, see stub.h.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <chrono>
+#include "stub.h"
+#include "uRTCLib.h"
+
+HardwareSerial Serial;
+TwoWire Wire;
+StubBus stub;
+
+static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+// Pin output latch and direction, as AVR PORT and DDR bits
+static uint8_t latch[2];
+static bool output[2];
+
+void stubReset()
+{
+	memset(&stub, 0, sizeof(stub));
+	stub.address = 0x68;
+	stub.wireOn = true;
+	latch[0] = latch[1] = HIGH;
+	output[0] = output[1] = false;
+}
+
+static struct StubInit
+{
+	StubInit() { stubReset(); }
+} stubInit;
+
+void stubSetTime(const uint32_t unixtime)
+{
+	DateTime time(unixtime);
+	stub.regs[0x00] = stubBcd(time.second());
+	stub.regs[0x01] = stubBcd(time.minute());
+	stub.regs[0x02] = stubBcd(time.hour());
+	stub.regs[0x03] = time.dayOfTheWeek() + 1;
+	stub.regs[0x04] = stubBcd(time.day());
+	stub.regs[0x05] = stubBcd(time.month());
+	stub.regs[0x06] = stubBcd(time.year() - 2000);
+}
+
+/*** Time ***/
+
+unsigned long micros()
+{
+	if (stub.onClock)
+	{
+		stub.onClock();
+	}
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() + stub.elapsedMicros;
+}
+
+unsigned long millis() { return micros() / 1000; }
+
+void delay(const unsigned long ms) { stub.elapsedMicros += ms * 1000; }
+
+void delayMicroseconds(const unsigned int us) { stub.elapsedMicros += us; }
+
+/*** Pins ***/
+
+static int pinIndex(const uint8_t pin) { return pin == STUB_SDA_PIN ? 0 : pin == STUB_SCL_PIN ? 1 : -1; }
+
+static bool driven(const int index, const uint8_t value) { return output[index] && latch[index] == value; }
+
+// Tracks SCL rising edges, which make a stuck slave shift out its byte, and pins driven high
+static void pinChanged(const int index, const bool wasLow)
+{
+	if (driven(index, HIGH))
+	{
+		stub.drivenHigh++;
+	}
+	if (index == 1 && wasLow && !driven(1, LOW))
+	{
+		stub.clocks++;
+		if (stub.stuck > 0)
+		{
+			stub.stuck--;
+		}
+	}
+}
+
+void pinMode(const uint8_t pin, const uint8_t mode)
+{
+	int index = pinIndex(pin);
+	if (index < 0)
+	{
+		return;
+	}
+	bool wasLow = driven(index, LOW);
+	output[index] = mode == OUTPUT;
+	if (mode != OUTPUT)
+	{
+		latch[index] = mode == INPUT_PULLUP ? HIGH : LOW;
+	}
+	pinChanged(index, wasLow);
+}
+
+void digitalWrite(const uint8_t pin, const uint8_t value)
+{
+	int index = pinIndex(pin);
+	if (index < 0)
+	{
+		return;
+	}
+	bool wasLow = driven(index, LOW);
+	latch[index] = value;
+	pinChanged(index, wasLow);
+}
+
+int digitalRead(const uint8_t pin)
+{
+	int index = pinIndex(pin);
+	if (index < 0)
+	{
+		return LOW;
+	}
+	// External pull-ups keep lines high unless driven low, or SDA is held by a stuck slave
+	return driven(index, LOW) || (index == 0 && stub.stuck > 0) ? LOW : HIGH;
+}
+
+/*** Wire ***/
+
+void TwoWire::begin()
+{
+	stub.wireOn = true;
+	stub.begins++;
+}
+
+void TwoWire::end() { stub.wireOn = false; }
+
+void TwoWire::beginTransmission(const int address)
+{
+	_address = address;
+	_txLength = 0;
+}
+
+size_t TwoWire::write(const uint8_t data)
+{
+	if (_txLength >= sizeof(_tx))
+	{
+		return 0;
+	}
+	_tx[_txLength++] = data;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, const size_t length)
+{
+	size_t written = 0;
+	while (written < length && write(data[written]))
+	{
+		written++;
+	}
+	return written;
+}
+
+uint8_t TwoWire::endTransmission(const bool)
+{
+	stub.transactions++;
+	if (!stub.wireOn || stub.stuck > 0)
+	{
+		return 4; // no START possible
+	}
+	if (_address != stub.address)
+	{
+		return 2;
+	}
+	if (_txLength > 1 && stub.fault == STUB_FAULT_NACK_DATA)
+	{
+		stub.fault = STUB_FAULT_NONE;
+		return 3;
+	}
+	if (_txLength > 0)
+	{
+		stub.pointer = _tx[0];
+	}
+	for (uint8_t i = 1; i < _txLength; i++)
+	{
+		stub.regs[stub.pointer++] = _tx[i];
+	}
+	if (_txLength > 1)
+	{
+		stub.writes++;
+	}
+	return 0;
+}
+
+uint8_t TwoWire::requestFrom(const int address, const int length)
+{
+	_rxLength = _rxIndex = 0;
+	if (!stub.wireOn || stub.stuck > 0 || address != stub.address)
+	{
+		return 0;
+	}
+	stub.reads++;
+	int count = length > (int)sizeof(_rx) ? (int)sizeof(_rx) : length;
+	if (stub.fault == STUB_FAULT_SHORT_READ && count > 0)
+	{
+		stub.fault = STUB_FAULT_NONE;
+		count--;
+	}
+	for (int i = 0; i < count; i++)
+	{
+		_rx[_rxLength++] = stub.regs[stub.pointer++];
+	}
+	return _rxLength;
+}
+
+int TwoWire::available() { return _rxLength - _rxIndex; }
+
+int TwoWire::read() { return _rxIndex < _rxLength ? _rx[_rxIndex++] : -1; }
@@ -0,0 +1,77 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host test stub: simulated RTC behind Wire, open drain I2C pins and a simulated clock.
+ *
+ * The RTC is a plain 256 register file with an auto-incremented pointer, so it stands for any supported model.
+ * Faults can be injected for next transaction, and a slave holding SDA low until clocked can be simulated.
+ *
+ * Pins behave as on AVR: a pin has an output latch, set by digitalWrite() and INPUT_PULLUP and cleared by INPUT;
+ * pinMode(OUTPUT) drives latch value. Driving an I2C line high is counted as a fault.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#ifndef URTCLIB_STUB_H
+#define URTCLIB_STUB_H
+#include "Arduino.h"
+#include "Wire.h"
+
+/**
+ * \brief No fault
+ */
+#define STUB_FAULT_NONE 0
+/**
+ * \brief Next write transaction gets a NACK on data
+ */
+#define STUB_FAULT_NACK_DATA 1
+/**
+ * \brief Next read transaction returns one byte less than requested
+ */
+#define STUB_FAULT_SHORT_READ 2
+
+/**
+ * \brief I2C pins used by the simulated bus
+ */
+#define STUB_SDA_PIN 4
+#define STUB_SCL_PIN 5
+
+/**
+ * \brief Simulated bus state, reset with stubReset()
+ */
+struct StubBus
+{
+	uint8_t regs[256];			///< RTC registers
+	uint8_t address;			///< RTC I2C address, other addresses get a NACK
+	uint8_t pointer;			///< RTC register pointer
+	uint8_t fault;				///< One shot fault for next transaction, STUB_FAULT_*
+	uint8_t stuck;				///< SCL clocks until a slave holding SDA low releases it, 0 if bus is free
+	bool wireOn;				///< Wire started, false after Wire.end()
+	unsigned long transactions; ///< Transactions started, including failed ones
+	unsigned long reads;		///< Read transactions
+	unsigned long writes;		///< Write transactions with data
+	unsigned long begins;		///< Wire.begin() calls
+	unsigned long clocks;		///< SCL rising edges made by hand
+	unsigned long drivenHigh;	///< Times an I2C pin was driven high, which must not happen on open drain lines
+	unsigned long elapsedMicros; ///< Simulated time, added to real time by millis() and micros()
+	void (*onClock)();			///< Called on every millis() and micros() if set, to preempt the caller right there
+};
+
+extern StubBus stub;
+
+void stubReset();
+
+/**
+ * \brief Sets registers from RTC as BCD, as an RTC running at that time
+ *
+ * @param unixtime Time to store
+ */
+void stubSetTime(const uint32_t unixtime);
+
+/**
+ * \brief Converts a binary value to BCD
+ */
+static inline uint8_t stubBcd(const uint8_t value) { return ((value / 10) << 4) | (value % 10); }
+
+#endif
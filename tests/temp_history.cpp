@@ -0,0 +1,107 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibTempHistory on a simulated DS3232 over 3 days, with a 3 hour MCU power off and a MCU reset: sampling period,
+ * no sampling during conversions, aggregates and hourly buckets against a reference, one RAM write per sample.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <cmath>
+#include <map>
+#include <vector>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3232);
+	memset(stub.regs + 0x14, 0xFF, 0xEC);
+	uRTCLibTempHistory *history = new uRTCLibTempHistory(rtc, 40);
+	CHECK(!history->begin());
+
+	std::map<uint32_t, std::vector<int> > hours; // stored samples by hour
+	int low = 255, high = 0, count = 0;
+	long sum = 0;
+	const uint32_t start = 1700000000;
+	uint32_t last = 0;
+	for (uint32_t t = start; t < start + 3 * 86400; t += 7)
+	{
+		if (t > start + 86400 + 5000 && t < start + 86400 + 5000 + 3 * 3600)
+			continue; // MCU off
+		if (t == start + 2 * 86400 + 7 * 1000)
+		{
+			delete history; // MCU reset
+			history = new uRTCLibTempHistory(rtc, 40);
+			CHECK(history->begin());
+		}
+		int quarters = (int)lround((25 + 10 * sin(t / 20000.0)) * 4);
+		stub.regs[0x11] = quarters >> 2;
+		stub.regs[0x12] = (quarters & 3) << 6;
+		bool busy = t % 1000 < 30; // conversion in progress, BSY or CONV
+		stub.regs[0x0E] = busy && t % 2 ? 0b00100000 : 0;
+		stub.regs[0x0F] = busy && !(t % 2) ? 0b00000100 : 0;
+
+		unsigned long reads = stub.reads, writes = stub.writes;
+		bool taken = history->update(t);
+		CHECK(taken == (!busy && (!count || t - last >= URTCLIB_TEMP_HISTORY_PERIOD)));
+		CHECK(taken || stub.writes == writes);
+		if (count && t - last < URTCLIB_TEMP_HISTORY_PERIOD)
+			CHECK(stub.reads == reads); // not time yet, no bus access
+		if (!taken)
+			continue;
+		// Header in one write, plus one per closed bucket
+		CHECK(stub.writes - writes == 1 + (count && t / 3600 != last / 3600 ? (t / 3600 - last / 3600 > 24 ? 24 : t / 3600 - last / 3600) : 0));
+
+		int value = (quarters * 25 + 4025) / 50;
+		hours[t / 3600].push_back(value);
+		low = value < low ? value : low;
+		high = value > high ? value : high;
+		sum += value;
+		count++;
+		last = t;
+	}
+	CHECK((int)history->samples() == count);
+	CHECK(history->min() == low * 50 - 4000 && history->max() == high * 50 - 4000);
+	CHECK(history->mean() == (int)(sum * 50 / count) - 4000);
+
+	for (uint8_t ago = 0; ago <= URTCLIB_TEMP_HISTORY_HOURS; ago++)
+	{
+		int16_t min, max, mean;
+		bool present = history->hour(ago, min, max, mean);
+		std::map<uint32_t, std::vector<int> >::const_iterator hour = hours.find(last / 3600 - ago);
+		CHECK(present == (hour != hours.end()));
+		if (!present || hour == hours.end())
+			continue;
+		int hourSum = 0, hourLow = 255, hourHigh = 0, n = hour->second.size();
+		for (int value : hour->second)
+		{
+			hourSum += value;
+			hourLow = value < hourLow ? value : hourLow;
+			hourHigh = value > hourHigh ? value : hourHigh;
+		}
+		CHECK(min == hourLow * 50 - 4000 && max == hourHigh * 50 - 4000 && mean == (hourSum + n / 2) / n * 50 - 4000);
+	}
+
+	// A day-long gap empties the ring
+	CHECK(history->update(last + 30 * 3600));
+	for (uint8_t ago = 1; ago <= URTCLIB_TEMP_HISTORY_HOURS; ago++)
+	{
+		int16_t min, max, mean;
+		CHECK(!history->hour(ago, min, max, mean));
+	}
+	delete history;
+
+	// Mean of a long history, where sum * 50 does not fit in 32 bits
+	uRTCLibTempHistory year(rtc, 40);
+	year.reset();
+	stub.regs[0x11] = 60; // 60.25C, stored as 60.5C
+	stub.regs[0x12] = 0x40;
+	for (uint32_t t = start; t < start + 500000UL * URTCLIB_TEMP_HISTORY_PERIOD; t += URTCLIB_TEMP_HISTORY_PERIOD)
+		year.update(t);
+	CHECK(year.samples() == 500000 && year.mean() == 6050);
+
+	return TEST_RESULT;
+}
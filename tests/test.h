@@ -0,0 +1,32 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Host tests: CHECK() reports a failed condition and goes on; main() returns TEST_RESULT, so ctest sees failures.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#ifndef URTCLIB_TEST_H
+#define URTCLIB_TEST_H
+#include <stdio.h>
+
+/**
+ * \brief Failed checks; only the first ones are printed, as randomized tests may fail on every iteration
+ */
+static unsigned long testFailures = 0;
+
+#define TEST_MAX_REPORTS 10
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition) && testFailures++ < TEST_MAX_REPORTS) \
+		{ \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+#define TEST_RESULT (testFailures ? printf("%lu failed checks\n", testFailures), 1 : 0)
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * uRTCLibTimebase on simulated 32KHz and 1Hz pulses: resolution, missed 1Hz edges and pulses counted by hardware.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include "uRTCLib.h"
+#include "test.h"
+
+// Ticks since sync, as counted by the stamp
+static uint64_t elapsed(uRTCLibTimebase &timebase, const uint32_t start)
+{
+	uint32_t unixtime;
+	uint16_t ticks;
+	timebase.stamp(unixtime, ticks);
+	CHECK(ticks < 32768);
+	return (uint64_t)(unixtime - start) * 32768 + ticks;
+}
+
+int main()
+{
+	const uint32_t start = 1700000000;
+
+	// Every edge of 3 seconds, with all 1Hz edges
+	uRTCLibTimebase timebase;
+	timebase.sync(start);
+	uint64_t tick = 0;
+	for (uint32_t second = 0; second < 3; second++)
+	{
+		for (uint16_t edge = 0; edge < 32768; edge++)
+		{
+			CHECK(elapsed(timebase, start) == tick);
+			timebase.pulse32KHz();
+			tick++;
+		}
+		timebase.pulse1Hz();
+	}
+	CHECK(elapsed(timebase, start) == tick);
+
+	// 1Hz edges missed for 0, 1, 2, 10 seconds and for a whole day
+	const uint32_t missed[] = {0, 1, 2, 10, 86400};
+	for (uint32_t seconds : missed)
+	{
+		uRTCLibTimebase lost;
+		lost.sync(start);
+		for (uint32_t second = 0; second < seconds; second++)
+		{
+			lost.pulse32KHz(32768);
+		}
+		lost.pulse32KHz(12345);
+		CHECK(elapsed(lost, start) == (uint64_t)seconds * 32768 + 12345);
+		// Next 1Hz edge, a few ticks off as edges are not in phase, keeps missed seconds
+		lost.pulse32KHz(32768 - 12345 - 3);
+		lost.pulse1Hz();
+		CHECK(elapsed(lost, start) == (uint64_t)(seconds + 1) * 32768);
+		lost.pulse32KHz(32768 + 2);
+		lost.pulse1Hz();
+		CHECK(elapsed(lost, start) == (uint64_t)(seconds + 2) * 32768);
+	}
+
+	// Hardware counter: edges fed in irregular batches
+	uRTCLibTimebase counter;
+	counter.sync(start);
+	uint64_t fed = 0;
+	for (uint16_t batch = 1; fed < 5 * 32768; batch = batch * 7 % 1000 + 1)
+	{
+		counter.pulse32KHz(batch);
+		fed += batch;
+		CHECK(elapsed(counter, start) == fed);
+	}
+
+	// 1Hz only, no 32KHz pulses
+	uRTCLibTimebase seconds;
+	seconds.sync(start);
+	for (int i = 0; i < 5; i++)
+	{
+		seconds.pulse1Hz();
+	}
+	CHECK(elapsed(seconds, start) == 5 * 32768);
+
+	// Tick conversion: 32768 ticks are one second
+	CHECK(uRTCLibTimebase::ticksToMicros(0) == 0);
+	CHECK(uRTCLibTimebase::ticksToMicros(1) == 30);
+	CHECK(uRTCLibTimebase::ticksToMicros(16384) == 500000);
+	CHECK(uRTCLibTimebase::ticksToMicros(32767) == 999969);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,114 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * I2C trace on an 8 entries ring: direction and length of long transfers, wrap-around keeping the last accesses in
+ * order, and dump() output decoded back with parse().
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+/**
+ * \brief Lines printed by dump(), as stub Serial prints to stdout
+ */
+static std::vector<std::string> dumped()
+{
+	fflush(stdout);
+	int saved = dup(1);
+	FILE *file = tmpfile();
+	dup2(fileno(file), 1);
+	uRTCLibTrace::dump(Serial);
+	fflush(stdout);
+	dup2(saved, 1);
+	close(saved);
+	std::string text;
+	rewind(file);
+	for (int c; (c = fgetc(file)) != EOF;)
+		text += (char)c;
+	fclose(file);
+
+	std::vector<std::string> lines;
+	std::istringstream in(text);
+	for (std::string line; std::getline(in, line);)
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		lines.push_back(line);
+	}
+	return lines;
+}
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3232);
+	uRTCLibTraceEntry entry;
+	uint16_t seq;
+	uint8_t buffer[200];
+
+	stubReset();
+	stubSetTime(DateTime(2026, 3, 1, 12, 0, 0).unixtime());
+	uRTCLibTrace::clear();
+
+	// Empty ring: header only, which is not an entry
+	std::vector<std::string> lines = dumped();
+	CHECK(lines.size() == 1 && lines[0] == "seq,address,reg,dir,length,result,us,data");
+	CHECK(!uRTCLibTrace::parse(lines[0].c_str(), seq, entry));
+
+	// Transfers of 128 bytes or more keep their length and direction
+	for (uint8_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = i;
+	CHECK(rtc.ramWrite(0, buffer, 200));
+	CHECK(rtc.ramRead(0, buffer, 200));
+	lines = dumped();
+	CHECK(lines.size() == 3);
+	CHECK(uRTCLibTrace::parse(lines[1].c_str(), seq, entry) && seq == 0);
+	CHECK(entry.write && entry.length == 200 && entry.reg == 0x14 && entry.address == 0x68 && entry.result == 0);
+	CHECK(entry.data[0] == 0 && entry.data[URTCLIB_TRACE_DATA - 1] == URTCLIB_TRACE_DATA - 1);
+	CHECK(uRTCLibTrace::parse(lines[2].c_str(), seq, entry) && seq == 1);
+	CHECK(!entry.write && entry.length == 200 && entry.reg == 0x14 && entry.result == 0);
+
+	// Wrap-around: 8 + 5 accesses keep the last 8, oldest first, with sequence numbers telling 5 were overwritten
+	uRTCLibTrace::clear();
+	for (uint8_t i = 0; i < 13; i++)
+		CHECK(rtc.ramWrite(i, &i, 1));
+	lines = dumped();
+	CHECK(lines.size() == 1 + URTCLIB_TRACE);
+	for (uint8_t i = 0; i < URTCLIB_TRACE && i + 1u < lines.size(); i++)
+	{
+		CHECK(uRTCLibTrace::parse(lines[i + 1].c_str(), seq, entry));
+		CHECK(seq == 5 + i && entry.write && entry.length == 1 && entry.reg == 0x14 + 5 + i && entry.data[0] == 5 + i);
+		CHECK(entry.data[1] == 0);
+	}
+
+	// Failed read: short read result
+	stub.fault = STUB_FAULT_SHORT_READ;
+	rtc.refresh();
+	lines = dumped();
+	bool found = false;
+	for (size_t i = 1; i < lines.size(); i++) // a retry may follow
+	{
+		CHECK(uRTCLibTrace::parse(lines[i].c_str(), seq, entry));
+		if (seq == 13)
+		{
+			found = true;
+			CHECK(!entry.write && entry.reg == 0 && entry.result == URTCLIB_ERROR_SHORT_READ && entry.length < 7);
+		}
+	}
+	CHECK(found);
+
+	// Malformed lines
+	CHECK(!uRTCLibTrace::parse("0,68,0,X,1,0,5,00", seq, entry));
+	CHECK(!uRTCLibTrace::parse("0,68,0,R,2,0,5,0", seq, entry));
+	CHECK(!uRTCLibTrace::parse("0,68,0,R,1,0,5", seq, entry));
+	CHECK(uRTCLibTrace::parse("7,68,E,R,1,0,5,1c", seq, entry) && seq == 7 && entry.reg == 0x0E && entry.data[0] == 0x1C);
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,43 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * nowUnix() and adjustUnix() against now() and adjust(): same time read back, same registers written.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <random>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	std::mt19937 rng(1);
+
+	for (long i = 0; i < 500000; i++)
+	{
+		// First ones step over every region of the calendar, leap days included; then random
+		uint32_t t = i < 4000 ? SECONDS_FROM_1970_TO_2000 + (uint32_t)i * 86400 * 11 + i : SECONDS_FROM_1970_TO_2000 + rng() % (0xFFFFFFFFUL - SECONDS_FROM_1970_TO_2000);
+
+		rtc.adjustUnix(t);
+		DateTime now = rtc.now();
+		CHECK(rtc.nowUnix() == t);
+		CHECK(now.unixtime() == t && now.dayOfTheWeek() == DateTime(t).dayOfTheWeek());
+
+		uint8_t registers[7];
+		rtc.adjust(DateTime(t));
+		memcpy(registers, stub.regs, 7);
+		rtc.adjustUnix(t);
+		CHECK(memcmp(registers, stub.regs, 7) == 0);
+	}
+
+	// A failed read returns 2000-01-01 00:00:00, as now()
+	stub.address = 0x50;
+	CHECK(rtc.nowUnix() == SECONDS_FROM_1970_TO_2000 && rtc.now().unixtime() == SECONDS_FROM_1970_TO_2000);
+	stub.address = 0x68;
+
+	return TEST_RESULT;
+}
@@ -0,0 +1,120 @@
+/**
+ * DS1307, DS3231 and DS3232 RTCs basic library
+ *
+ * Wake latency: alarmLastFire() against a second by second scan of DS3231 alarm matching, wake sample print() /
+ * parse() round trip with replayed histograms, and a live chain on the simulated RTC.
+ *
+ * @see <a href="https://github.com/Naguissa/uRTCLib">https://github.com/Naguissa/uRTCLib</a>
+ * @see <a href="mailto:naguissa@foroelectro.net">naguissa@foroelectro.net</a>
+ * @version 6.2.4
+ */
+#include <random>
+#include <string>
+#include <unistd.h>
+#include "uRTCLib.h"
+#include "stub.h"
+#include "test.h"
+
+/**
+ * \brief DS3231 alarm matching, on alarmSet() arguments
+ */
+static bool matches(const uint8_t type, const uint8_t second, const uint8_t minute, const uint8_t hour, const uint8_t day, const DateTime &t)
+{
+	if (type & 0x80 ? t.second() != 0 : !(type & 0x01) && t.second() != second) // Alarm 2 fires on second 0
+		return false;
+	if ((!(type & 0x02) && t.minute() != minute) || (!(type & 0x04) && t.hour() != hour))
+		return false;
+	if (!(type & 0x08) && (type & 0x10 ? t.dayOfTheWeek() + 1 != day : t.day() != day))
+		return false;
+	return true;
+}
+
+/**
+ * \brief Serial output of a probe call, as stub Serial prints to stdout
+ */
+template <typename F>
+static std::string captured(F call)
+{
+	fflush(stdout);
+	int saved = dup(1);
+	FILE *file = tmpfile();
+	dup2(fileno(file), 1);
+	call();
+	fflush(stdout);
+	dup2(saved, 1);
+	close(saved);
+	std::string text;
+	rewind(file);
+	for (int c; (c = fgetc(file)) != EOF;)
+		text += (char)c;
+	fclose(file);
+	return text;
+}
+
+int main()
+{
+	uRTCLib rtc(0x68, URTCLIB_MODEL_DS3231);
+	std::mt19937 rng(5);
+	const uint8_t types[] = {URTCLIB_ALARM_TYPE_1_ALL_S, URTCLIB_ALARM_TYPE_1_FIXED_S, URTCLIB_ALARM_TYPE_1_FIXED_MS, URTCLIB_ALARM_TYPE_1_FIXED_HMS,
+													 URTCLIB_ALARM_TYPE_1_FIXED_DHMS, URTCLIB_ALARM_TYPE_1_FIXED_DOWHMS, URTCLIB_ALARM_TYPE_2_ALL_M, URTCLIB_ALARM_TYPE_2_FIXED_M,
+													 URTCLIB_ALARM_TYPE_2_FIXED_HM, URTCLIB_ALARM_TYPE_2_FIXED_DHM, URTCLIB_ALARM_TYPE_2_FIXED_DOWHM};
+
+	for (int i = 0; i < 500; i++)
+	{
+		uint8_t type = types[rng() % (sizeof(types) / sizeof(types[0]))];
+		uint8_t second = rng() % 60, minute = rng() % 60, hour = rng() % 24;
+		uint8_t day = type & 0x10 ? 1 + rng() % 7 : 1 + rng() % 31;
+		rtc.alarmSet(type, second, minute, hour, day);
+		DateTime now(1000000000UL + rng() % 2000000000UL), fire;
+		bool found = rtc.alarmLastFire(type & 0x80 ? URTCLIB_ALARM_2 : URTCLIB_ALARM_1, now, fire);
+
+		// Day of month alarms may be up to 62 days back, or never (day 31 in short months only)
+		uint32_t reference = 0;
+		DateTime t(now);
+		for (uint32_t back = 0; back < 70UL * 86400 && !reference; back++, t.addSeconds(-1))
+		{
+			if (matches(type, second, minute, hour, day, t))
+				reference = t.unixtime();
+		}
+		CHECK(found == (reference != 0));
+		CHECK(!found || fire.unixtime() == reference);
+	}
+
+	// Printed samples replay to the same histograms
+	uRTCLibWakeProbe live(rtc), replay(rtc);
+	for (int i = 0; i < 1000; i++)
+	{
+		uRTCLibWakeSample sample;
+		sample.fell = rng();
+		sample.woke = sample.fell + rng() % 5000;
+		sample.clearing = sample.woke + rng() % 100;
+		sample.cleared = sample.clearing + rng() % (1UL << (rng() % 24));
+		sample.rtcLag = (int)(rng() % 5) - 1;
+		sample.source = i % 3 == 0 ? URTCLIB_WAKE_SQW : (i % 3 == 1 ? URTCLIB_ALARM_1 : URTCLIB_ALARM_2);
+		sample.ok = rng() & 1;
+		live.add(sample);
+
+		std::string line = captured([&] { live.print(Serial, sample); });
+		uRTCLibWakeSample parsed;
+		CHECK(uRTCLibWakeProbe::parse(line.c_str(), parsed));
+		CHECK(parsed.fell == sample.fell && parsed.woke == sample.woke && parsed.clearing == sample.clearing && parsed.cleared == sample.cleared);
+		CHECK(parsed.rtcLag == sample.rtcLag && parsed.source == sample.source && parsed.ok == sample.ok);
+		replay.add(parsed);
+	}
+	CHECK(captured([&] { live.dump(Serial); }) == captured([&] { replay.dump(Serial); }));
+	uRTCLibWakeSample parsed;
+	CHECK(!uRTCLibWakeProbe::parse("wake,1,2", parsed) && !uRTCLibWakeProbe::parse("sleep,1,2,3,4,5,6,7", parsed));
+
+	// Alarm fired at 10:20:30 and is handled at 10:20:33
+	rtc.adjust(DateTime(2024, 3, 5, 10, 20, 33));
+	rtc.alarmSet(URTCLIB_ALARM_TYPE_1_FIXED_HMS, 30, 20, 10, 0);
+	stub.regs[0x0F] |= 0b00000001; // A1F
+	live.pinFell();
+	live.woke();
+	CHECK(live.handled(URTCLIB_ALARM_1));
+	CHECK(live.last().ok && live.last().rtcLag == 3 && live.last().source == URTCLIB_ALARM_1);
+	CHECK(!(stub.regs[0x0F] & 0b00000001));
+	CHECK(live.last().fell <= live.last().woke && live.last().woke <= live.last().clearing && live.last().clearing <= live.last().cleared);
+
+	return TEST_RESULT;
+}